@@ -32,8 +32,19 @@
 #include <stddef.h>
 #include <stdint.h>
 
+// The snprintf wrapper macro of the header would replace the definition of the function
+#ifndef LIBCJ_NO_CONSTANT_FMT
+#define LIBCJ_NO_CONSTANT_FMT
+#endif // LIBCJ_NO_CONSTANT_FMT
 #include "libcj.h"
 
+#ifdef LIBCJ_POSIX
+#include <errno.h>
+#include <pthread.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
 //------------------------------------------------------------------------------
 // DEFINITIONS
 //------------------------------------------------------------------------------
@@ -46,6 +57,15 @@
 #define INLINE_FUNCTION
 #endif
 
+// Keeps the large stack frames of rarely used functions out of their callers
+#ifdef __GNUC__
+#define NOINLINE_FUNCTION __attribute__((noinline))
+#elif defined(_MSC_VER)
+#define NOINLINE_FUNCTION __declspec(noinline)
+#else
+#define NOINLINE_FUNCTION
+#endif
+
 #if defined(__cplusplus) && (__cplusplus >= 201103L)
 #define THREAD_LOCAL thread_local
 #elif defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 201112L)
@@ -65,19 +85,7 @@
 #define LOCAL_BUFFER_SIZE 1024 // This should be enough for everyone
 
 #define VALUE_TO_CHAR(value, uppercase) \
-    (((value) < 10) ? ((value) + '0') : (value - 10 + ((uppercase) ? 'A' : 'a')))
-
-#define PUTCHAR(c)              \
-    do {                        \
-        if (sz == NULL) {       \
-            **buf = (c);        \
-            (*buf)++;           \
-        } else if (*sz > 1) {   \
-            **buf = (c);        \
-            (*buf)++;           \
-            (*sz)--;            \
-        }                       \
-    } while (0)
+    (((value) < 10) ? ((value) + '0') : ((value) - 10 + ((uppercase) ? 'A' : 'a')))
 
 #define SKIP_WHITESPACES(buf)   \
     do {                        \
@@ -112,6 +120,8 @@ enum Fmt_Specifier {
     Fmt_d, Fmt_i, Fmt_u, Fmt_o, Fmt_x,
     Fmt_f, Fmt_e, Fmt_g, Fmt_a,
     Fmt_c, Fmt_s, Fmt_p, Fmt_n, Fmt_percent,
+    Fmt_json, Fmt_cstr, // Escaped strings
+    Fmt_custom, // Registered with cj_fmt_register
     Fmt_unknown
 };
 
@@ -124,8 +134,127 @@ enum Fmt_Flags {
     Flag_Hash  = 0x08,
     Flag_Zero  = 0x10,
     Flag_Upper = 0x20,
-    Flag_Exp   = 0x40, // Float number exponential form
-    Flag_Short = 0x80, // Float number short form
+};
+
+// Width or precision given by an argument ('*'), that is only read when the conversion is executed
+#define FMT_FROM_ARGUMENT INT_MIN
+
+// Conversion specification parsed from a format string
+struct Fmt_Spec {
+    enum Fmt_Flags flags;
+    int width; // -1 if not informed
+    int precision; // -1 if not informed
+    enum Fmt_Specifier specifier;
+    enum Length_Modifier modifier;
+    char letter; // Letter of custom conversions
+};
+
+// String literals that strings can be escaped for
+enum Escape_Style {
+    Escape_json,
+    Escape_c
+};
+
+// Wraps the variable argument list, so that it can be shared by pointer between functions
+// The arguments can also be read from the fields of a row (of cj_format_rows), at the given offsets
+struct Fmt_Args {
+    va_list list;
+    const char *row; // NULL when the arguments come from the list
+    const size_t *offsets;
+    size_t field;
+    bool store_counts; // Of the rows, false when their position in the output isn't known yet
+};
+
+// Decimal floating point number in the form (-1)^negative * mantissa * 10^exponent
+struct Decimal {
+    uint64_t mantissa;
+    int exponent;
+    bool negative;
+    // Digits that didn't fit in the mantissa, they are only needed for exact conversions
+    bool truncated; // At least one of the discarded digits isn't zero
+    int discarded_digits;
+    const char *first_discarded;
+};
+
+enum Float_Kind {
+    Float_Finite, Float_Infinite, Float_NaN
+};
+
+// Binary floating point number in the form (-1)^negative * mantissa * 2^exponent
+struct Binary_Float {
+    uint64_t mantissa;
+    int exponent;
+    bool negative;
+    enum Float_Kind kind;
+};
+
+// Binary floating point format, described by the exponents of its smallest normal
+// number (1.0 * 2^min_exponent) and its largest finite number (1.xxx * 2^max_exponent)
+struct Float_Format {
+    int mantissa_bits; // Including the implicit bit
+    int min_exponent;
+    int max_exponent;
+};
+
+// Maximum amount of significant decimal digits considered when parsing floating point
+// numbers, further digits are only used to round correctly in case of ties
+#define DECIMAL_MAX_DIGITS 800
+
+// Capacity of the big integers, enough for the exact conversion of any long double
+// The largest one is 10^n, where n is the amount of decimal digits of the smallest
+// subnormal long double with DECIMAL_MAX_DIGITS digits, with at most 10/3 bits per digit
+// The extra limbs leave room to normalize the divisor and to generate 9 digits at once
+#define BIG_INT_LIMBS \
+    (((DECIMAL_MAX_DIGITS + LDBL_MANT_DIG - LDBL_MIN_10_EXP + 2) * 10 / 3) / 32 + 4)
+
+// Arbitrary precision unsigned integer, used to convert floating point numbers exactly
+struct Big_Int {
+    int size; // Amount of limbs in use
+    uint32_t limbs[BIG_INT_LIMBS]; // Least significant limb first
+};
+
+// Generator of the decimal digits of a nonzero binary floating point number (Dragon4)
+// The value is r/s * 10^(exponent+1), with 0.1 <= r/s < 1, and the digits are
+// generated in chunks of 9, each one with a single division of big integers
+struct Digit_Generator {
+    struct Big_Int r, s;
+    int exponent; // Decimal exponent of the first digit
+    char chunk[9];
+    int chunk_index; // Index of the next digit in the chunk
+};
+
+// Amount of decimal digits that are stored while they are rounded, the next ones are
+// generated again when printed, so that any precision is supported
+#define FLOAT_DIGITS_CACHE_SIZE 64
+
+// Decimal digits of a floating point number, correctly rounded at some position
+// The digits are read in order, and the first one has weight 10^exponent
+struct Float_Digits {
+    struct Binary_Float value;
+    struct Digit_Generator generator;
+    char cache[FLOAT_DIGITS_CACHE_SIZE];
+    int count; // Amount of digits up to the rounding position, the next ones are zeros
+    int exponent;
+    bool round_up;
+    bool carried; // Rounding up carried over all digits, so they are 1 followed by zeros
+    int last_non_nine; // Index of the digit that receives the carry when rounding up
+    int last_nonzero; // Index of the last nonzero digit after rounding, or -1 if all are zeros
+    int next; // Index of the next digit to be read
+};
+
+// Destination of the formatted output. Characters are written at cursor while there is
+// room, and when it runs out the overflow function is called to make more room. If it
+// can't (or there is no overflow function), the rest of the output is discarded
+// A byte after the room is always reserved for the null termination, unless cursor is NULL
+struct Sink {
+    char *cursor; // Next position to be written, NULL when the output is only counted
+    size_t room;  // Amount of characters that can still be written at cursor
+    bool (*overflow)(struct Sink *sink); // Returns true if the room was increased
+    // Optional, consumes the characters that doesn't fit in the room without copying them
+    bool (*write_through)(struct Sink *sink, const char *str, size_t len);
+    // Optional, consumes len copies of the character c that don't fit in the room
+    bool (*fill_through)(struct Sink *sink, char c, size_t len);
+    void *context; // Used by the overflow, write_through and fill_through functions
 };
 
 //------------------------------------------------------------------------------
@@ -169,6 +298,282 @@ LIBCJ_FN bool char_in_scanset(const char *scanset, const char c)
     return found;
 }
 
+// Returns the number of trailing zero bits of x, which must be nonzero
+LIBCJ_FN int count_trailing_zeros(uint64_t x)
+{
+#ifdef __GNUC__
+    return __builtin_ctzll(x);
+#else
+    int count = 0;
+    while ((x & 1) == 0) {
+        x >>= 1;
+        count++;
+    }
+    return count;
+#endif
+}
+
+// Loads 8 bytes from str as a little-endian word, independently of the host endianness
+LIBCJ_FN uint64_t load_word(const char *const str)
+{
+    uint64_t word = 0;
+    for (int i = 0; i < 8; i++) {
+        word |= (uint64_t)(unsigned char)str[i] << (8*i);
+    }
+    return word;
+}
+
+// Checks if all the 8 bytes of the word are decimal digits
+LIBCJ_FN bool word_is_eight_digits(const uint64_t word)
+{
+    return ((word & 0xF0F0F0F0F0F0F0F0) | (((word + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4)) == 0x3333333333333333;
+}
+
+// Converts a word of 8 decimal digits (the first digit in the lowest byte) to its value,
+// combining pairs of digits, then pairs of pairs and so on with three multiplications
+LIBCJ_FN uint32_t word_to_eight_digits(uint64_t word)
+{
+    word = ((word & 0x0F0F0F0F0F0F0F0F) * 2561) >> 8;
+    word = ((word & 0x00FF00FF00FF00FF) * 6553601) >> 16;
+    return (uint32_t)(((word & 0x0000FFFF0000FFFF) * 42949672960001) >> 32);
+}
+
+// Converts a value less than 10^8 to a word of 8 decimal digits (the first digit in the lowest byte),
+// the reverse of word_to_eight_digits. The value is split in halves of 4 digits, each half in pairs
+// and each pair in digits, with a multiplication by the inverse of 100 and 10 for all the lanes at once
+LIBCJ_FN uint64_t eight_digits_to_word(const uint32_t value)
+{
+    const uint64_t halves = (value / 10000) | ((uint64_t)(value % 10000) << 32);
+    const uint64_t hundreds = ((halves * 10486) >> 20) & 0x0000007F0000007F;
+    const uint64_t pairs = ((halves - 100 * hundreds) << 16) | hundreds;
+    const uint64_t tens = ((pairs * 103) >> 10) & 0x000F000F000F000F;
+    const uint64_t digits = ((pairs - 10 * tens) << 8) | tens;
+    return digits | 0x3030303030303030;
+}
+
+// Returns a mask with the most significant bit of each byte of the word set if that byte is equal to c
+// It is exact for all bytes, adding within the lower 7 bits doesn't carry between bytes
+LIBCJ_FN uint64_t word_bytes_equal(const uint64_t word, const char c)
+{
+    const uint64_t x = word ^ (0x0101010101010101 * (unsigned char)c);
+    return ~(((x & 0x7F7F7F7F7F7F7F7F) + 0x7F7F7F7F7F7F7F7F) | x | 0x7F7F7F7F7F7F7F7F);
+}
+
+// Returns a mask with the most significant bit of each byte of the word set if that byte is
+// a control character (lower than 0x20)
+LIBCJ_FN uint64_t word_control_bytes(const uint64_t word)
+{
+    return ~(((word & 0x7F7F7F7F7F7F7F7F) + 0x6060606060606060) | word | 0x7F7F7F7F7F7F7F7F);
+}
+
+// Returns the index of the first byte of the word equal to c, or 8 if there is none
+LIBCJ_FN int word_find_byte(const uint64_t word, const char c)
+{
+    const uint64_t found = word_bytes_equal(word, c);
+    if (found == 0) {
+        return 8;
+    }
+    return count_trailing_zeros(found) / 8;
+}
+
+// Stores a word in str as 8 bytes in little-endian order, independently of the host endianness
+LIBCJ_FN void store_word(char *const str, const uint64_t word)
+{
+    for (int i = 0; i < 8; i++) {
+        str[i] = (char)((word >> (8*i)) & 0xFF);
+    }
+}
+
+// Returns a mask with the most significant bit of each byte of the word set if that
+// byte is in the range [low, high]. All bytes of the word must be lower than 0x80
+#define WORD_BYTES_IN_RANGE(word, low, high) \
+    ((((word) + 0x0101010101010101 * (0x80 - (low))) & \
+    ~((word) + 0x0101010101010101 * (0x7F - (high)))) & 0x8080808080808080)
+
+// Checks if all the 8 bytes of the word are hexadecimal digits
+LIBCJ_FN bool word_is_eight_hex_digits(const uint64_t word)
+{
+    if ((word & 0x8080808080808080) != 0) {
+        return false;
+    }
+    const uint64_t lower = word | 0x2020202020202020;
+    return (WORD_BYTES_IN_RANGE(word, '0', '9') | WORD_BYTES_IN_RANGE(lower, 'a', 'f')) == 0x8080808080808080;
+}
+
+// Converts each byte of a word of 8 hexadecimal digits to its value (nibble)
+LIBCJ_FN uint64_t word_to_nibbles(const uint64_t word)
+{
+    // Letters have the bit 6 set, and their 4 lower bits are 1 for 'a' up to 6 for 'f'
+    return (word & 0x0F0F0F0F0F0F0F0F) + 9 * ((word >> 6) & 0x0101010101010101);
+}
+
+// Converts a word of 8 hexadecimal digits (the first digit in the lowest byte) to its value,
+// merging pairs of nibbles, then pairs of bytes and pairs of 16 bits with shifts
+LIBCJ_FN uint32_t word_to_eight_hex_digits(const uint64_t word)
+{
+    uint64_t x = word_to_nibbles(word);
+    x = ((x << 4) | (x >> 8)) & 0x00FF00FF00FF00FF;
+    x = ((x << 8) | (x >> 16)) & 0x0000FFFF0000FFFF;
+    return (uint32_t)((x << 16) | (x >> 32));
+}
+
+// Invalid value in the table digit_values
+#define XX 0xFF
+
+// Value of each character when used as a digit in bases up to 36
+static const unsigned char digit_values[256] = {
+    XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+    XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+    XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+     0,  1,  2,  3,  4,  5,  6,  7,  8,  9, XX, XX, XX, XX, XX, XX,
+    XX, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24,
+    25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, XX, XX, XX, XX, XX,
+    XX, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24,
+    25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, XX, XX, XX, XX, XX,
+    XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+    XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+    XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+    XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+    XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+    XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+    XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+    XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+};
+
+#undef XX
+
+// Returns the value of the character c when used as a digit
+#define DIGIT_VALUE(c) ((int)digit_values[(unsigned char)(c)])
+
+// Returns the number of leading zero bits of x, which must be nonzero
+LIBCJ_FN int count_leading_zeros(uint64_t x)
+{
+#ifdef __GNUC__
+    return __builtin_clzll(x);
+#else
+    int count = 0;
+    while ((x & (1ULL << 63)) == 0) {
+        x <<= 1;
+        count++;
+    }
+    return count;
+#endif
+}
+
+// Returns the amount of bits of the given value
+LIBCJ_FN int bit_length(const uintmax_t value)
+{
+    return (value == 0) ? 0 : (64 - count_leading_zeros((uint64_t)value));
+}
+
+// Powers of ten that fit in 64 bits
+static const uint64_t uint64_powers_of_ten[] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+    100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL,
+    10000000000000ULL, 100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+    100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL,
+};
+
+// Returns the amount of decimal digits of the given value (at least one)
+LIBCJ_FN int decimal_length(const uint64_t value)
+{
+    // 1233 / 4096 is a little more than log10(2)
+    const uint64_t x = value | 1; // Zero has one digit, like one
+    const int guess = (bit_length(x) * 1233) >> 12;
+    return guess + ((x >= uint64_powers_of_ten[guess]) ? 1 : 0);
+}
+
+// Returns the amount of digits of the given value (at least one) in a base 2^shift
+LIBCJ_FN int pow2_length(const uint64_t value, const int shift)
+{
+    return (bit_length(value | 1) + shift - 1) / shift;
+}
+
+// Decimal representation of the numbers from 0 to 99
+static const char digit_pairs[201] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+// Writes the 'length' decimal digits of value into str, two digits per division
+// Each pair is written directly in its final position, so no reversal is needed
+LIBCJ_FN void write_decimal(char *const str, uint64_t value, int length)
+{
+    while (length >= 2) {
+        const unsigned int pair = (unsigned int)(value % 100) * 2;
+        value /= 100;
+        length -= 2;
+        str[length] = digit_pairs[pair];
+        str[length+1] = digit_pairs[pair+1];
+    }
+    if (length > 0) {
+        str[0] = (char)('0' + value);
+    }
+}
+
+// Writes the 'length' digits of value into str, in a base 2^shift (up to 16)
+LIBCJ_FN void write_pow2(char *const str, uint64_t value, const int length, const int shift, const bool uppercase)
+{
+    const char *const digits = uppercase ? "0123456789ABCDEF" : "0123456789abcdef";
+    const uint64_t mask = (1ULL << shift) - 1;
+    for (int index = length - 1; index >= 0; index--) {
+        str[index] = digits[value & mask];
+        value >>= shift;
+    }
+}
+
+// Converts 'len' digits (already validated) in a power of two base to an unsigned integer
+// The base is informed by its logarithm in base 2 ('shift'), so that each digit is added
+// with a shift instead of a multiplication. Hexadecimal digits are handled 8 at a time
+// Sets 'overflow' if the value doesn't fit in an uintmax_t
+LIBCJ_FN uintmax_t pow2_digits_to_uint(const char *str, int len, const int shift, bool *const overflow)
+{
+    uintmax_t value = 0;
+    while ((len > 0) && (*str == '0')) {
+        str++;
+        len--;
+    }
+    *overflow = (len > 0) &&
+        (((len - 1) * shift + bit_length((uintmax_t)DIGIT_VALUE(*str))) > (int)(sizeof(uintmax_t) * CHAR_BIT));
+    if (*overflow) {
+        return UINTMAX_MAX;
+    }
+    if (shift == 4) {
+        for (; len >= 8; str += 8, len -= 8) {
+            value = (value << 32) | word_to_eight_hex_digits(load_word(str));
+        }
+    }
+    for (; len > 0; str++, len--) {
+        value = (value << shift) | (uintmax_t)DIGIT_VALUE(*str);
+    }
+    return value;
+}
+
+// Returns the logarithm in base 2 of the base if it is a power of two, or zero otherwise
+LIBCJ_FN int pow2_base_shift(const int base)
+{
+    switch (base) {
+    case 2:  return 1;
+    case 4:  return 2;
+    case 8:  return 3;
+    case 16: return 4;
+    case 32: return 5;
+    default: return 0;
+    }
+}
+
+// Specializes pow2_digits_to_uint for each base, so that the compiler can
+// propagate the constant shift of the base into the conversion loop
+LIBCJ_FN uintmax_t base_digits_to_uint(const char *const str, const int len, const int base, bool *const overflow)
+{
+    switch (base) {
+    case 2:  return pow2_digits_to_uint(str, len, 1, overflow);
+    case 8:  return pow2_digits_to_uint(str, len, 3, overflow);
+    case 16: return pow2_digits_to_uint(str, len, 4, overflow);
+    default: return pow2_digits_to_uint(str, len, pow2_base_shift(base), overflow);
+    }
+}
+
 // Important: Our library currently contains a significant amount of redundancy
 // and duplicated code, particularly within the functions responsible for converting
 // strings into numerical values. Each of these conversion functions possesses
@@ -199,44 +604,6 @@ LIBCJ_FN int str_to_natural(const char *const str, int *const value)
     return index;
 }
 
-// Parses a string into a sign integer
-// The number may be preceded by optional sign
-// When a positive overflow occurs, the 'value' is set to INT_MAX, and conversely,
-// in the case of negative overflow, 'value' is assigned to INT_MIN
-// If width is greather than zero, it parses at most width characters
-// Returns the amount of characters that were consumed
-LIBCJ_FN int str_to_sign_integer(const char *const str, const int width, int *const value)
-{
-    const int base = 10;
-    int index = 0;
-    bool negative = false;
-    *value = 0;
-    if ((str[index] == '+') || (str[index] == '-')) {
-        negative = str[index] == '-';
-        index++;
-    }
-    for (; ((width < 0) || (index < width)) && (str[index] != '\0'); index++) {
-        if (!isdigit(str[index])) {
-            break;
-        }
-        const int digit = str[index] - '0';
-        if (negative) {
-            if (*value >= INT_MIN / base) {
-                *value = base * (*value) - digit;
-            } else {
-                *value = INT_MIN;
-            }
-        } else {
-            if (*value <= INT_MAX / base) {
-                *value = base * (*value) + digit;
-            } else {
-                *value = INT_MAX;
-            }
-        }
-    }
-    return index;
-}
-
 // Generic function to convert string into integers in bases 0, 8, 10 or 16
 // Returns the amount of characters that were consumed
 // If width is greather than zero, it parses at most width characters
@@ -265,31 +632,148 @@ static int str_to_int(const char *const str, int width, int base, intmax_t *cons
     if (base == 0) { // Default base
         base = 10;
     }
-    for (; ((width < 0) || (index < width)) && (str[index] != '\0'); index++) {
-        const char c = str[index];
-        int digit = 0;
-        if (isdigit(c)) {
-            digit = c - '0';
-        } else if ((base > 10) && isalpha(c)) {
-            digit = tolower(c) - 'a' + 10;
-        } else {
-            break;
-        }
-        if (digit >= base) {
-            break;
+    const int begin = index;
+    while (((width < 0) || (index < width)) && (DIGIT_VALUE(str[index]) < base)) {
+        index++;
+    }
+    uintmax_t magnitude = 0;
+    if (pow2_base_shift(base) != 0) {
+        bool overflow;
+        magnitude = base_digits_to_uint(&str[begin], index - begin, base, &overflow);
+    } else {
+        for (int i = begin; i < index; i++) {
+            magnitude = (uintmax_t)base * magnitude + (uintmax_t)DIGIT_VALUE(str[i]);
         }
-        *value = base * (*value) + ((negative) ? -digit : digit);
     }
+    *value = (intmax_t)(negative ? (0 - magnitude) : magnitude);
     return index;
 }
 
-// Generic function to convert integer numbers to string
+// Sink that writes into a buffer of size sz (including the null termination)
+// If sz is NULL the buffer is assumed to be large enough, and if it is zero nothing is written
+LIBCJ_FN void sink_buffer(struct Sink *const sink, char *const buf, const size_t *const sz)
+{
+    sink->cursor = ((sz == NULL) || (*sz > 0)) ? buf : NULL;
+    sink->room = (sz == NULL) ? SIZE_MAX : ((*sz > 0) ? (*sz - 1) : 0);
+    sink->overflow = NULL;
+    sink->write_through = NULL;
+    sink->fill_through = NULL;
+    sink->context = NULL;
+}
+
+// Sink that discards everything, used when only the length of the output is needed
+LIBCJ_FN void sink_counter(struct Sink *const sink)
+{
+    sink_buffer(sink, NULL, &(size_t){0});
+}
+
+// Checks if everything written to the sink from now on is discarded, so that the conversions
+// only need to compute the length of their output
+LIBCJ_FN bool sink_discards(const struct Sink *const sink)
+{
+    return (sink->room == 0) && (sink->overflow == NULL) && (sink->write_through == NULL) && (sink->fill_through == NULL);
+}
+
+LIBCJ_FN bool sink_make_room(struct Sink *const sink)
+{
+    return (sink->overflow != NULL) && sink->overflow(sink) && (sink->room > 0);
+}
+
+LIBCJ_FN void sink_putc(struct Sink *const sink, const char c)
+{
+    if ((sink->room > 0) || sink_make_room(sink)) {
+        *sink->cursor++ = c;
+        sink->room--;
+    }
+}
+
+// Writes len characters from str, with a single copy while they fit in the room
+static void sink_append(struct Sink *const sink, const char *str, size_t len)
+{
+    if ((len > sink->room) && (sink->write_through != NULL) && sink->write_through(sink, str, len)) {
+        return;
+    }
+    while (len > sink->room) {
+        const size_t room = sink->room;
+        if (room > 0) {
+            memcpy(sink->cursor, str, room);
+            sink->cursor += room;
+            sink->room = 0;
+            str += room;
+            len -= room;
+        }
+        if (!sink_make_room(sink)) {
+            return;
+        }
+    }
+    if (len > 0) {
+        memcpy(sink->cursor, str, len);
+        sink->cursor += len;
+        sink->room -= len;
+    }
+}
+
+// Writes the character c count times (nothing if count isn't positive)
+static void sink_fill(struct Sink *const sink, const char c, const int count)
+{
+    size_t len = (count > 0) ? (size_t)count : 0;
+    if ((len > sink->room) && (sink->fill_through != NULL) && sink->fill_through(sink, c, len)) {
+        return;
+    }
+    while (len > sink->room) {
+        const size_t room = sink->room;
+        if (room > 0) {
+            memset(sink->cursor, c, room);
+            sink->cursor += room;
+            sink->room = 0;
+            len -= room;
+        }
+        if (!sink_make_room(sink)) {
+            return;
+        }
+    }
+    if (len > 0) {
+        memset(sink->cursor, c, len);
+        sink->cursor += len;
+        sink->room -= len;
+    }
+}
+
+// Null terminates the output, in the byte reserved after the room
+LIBCJ_FN void sink_terminate(struct Sink *const sink)
+{
+    if (sink->cursor != NULL) {
+        *sink->cursor = '\0';
+    }
+}
+
+// Writes the 'length' digits of value in base 10 or in a power of two base
+// The digits are converted directly into the destination when it has enough space
+static void put_digits(struct Sink *const sink, const uintmax_t value, const int length, const int base, const bool uppercase)
+{
+    char str[CHAR_BIT * sizeof(uintmax_t)];
+    const bool direct = sink->room >= (size_t)length;
+    char *const digits = direct ? sink->cursor : str;
+    if (base == 10) {
+        write_decimal(digits, value, length);
+    } else {
+        write_pow2(digits, value, length, pow2_base_shift(base), uppercase);
+    }
+    if (direct) {
+        sink->cursor += length;
+        sink->room -= (size_t)length;
+    } else {
+        sink_append(sink, str, (size_t)length);
+    }
+}
+
+// Generic function to convert integer numbers to string, in base 8, 10 or 16
+// The output length is computed up front, so everything is written in order
 // Return the amount of characters that would have been written if we had enough size
-static int int_to_str(char **buf, size_t *const sz,
+static int int_to_str(struct Sink *const sink,
     const int width, const int precision, const enum Fmt_Flags flags, const int base,
     const bool sign, const intmax_t value)
 {
-    char str[LOCAL_BUFFER_SIZE]; 
     const bool left_justify = (flags & Flag_Minus) != 0;
     const bool negative = sign && (value < 0);
     const bool uppercase = (flags & Flag_Upper) != 0;
@@ -303,572 +787,4094 @@ static int int_to_str(char **buf, size_t *const sz,
     // Flag_Zero is ignored if precision or Flag_Minus are informed
     const int left_pad_zeros = (flags & Flag_Zero) ? (width-left_padding) : 0;
     const int zeros = use_precision ? precision : left_pad_zeros;
-    uintmax_t x = (uintmax_t)(negative ? (-value) : value);
-    int written = 0;
-    do {
-        str[written++] = VALUE_TO_CHAR((char)(x % (unsigned int)base), uppercase);
-        x /= (unsigned int)base;
-    } while (x > 0);
-    while (written < zeros) {
-        str[written++] = '0';
-    }
-    if (base_padding) {
-        switch (base) {
-        case 8:
-            if ((!use_precision || ((written > 0) && (str[written-1] != '0')))) {
-                str[written++] = '0';
-            }
-            break;
-        case 16:
-            str[written++] = uppercase ? 'X' : 'x';
-            str[written++] = '0';
-            break;
-        }
+    const uintmax_t x = negative ? (0 - (uintmax_t)value) : (uintmax_t)value;
+    const int digits = (base == 10) ? decimal_length(x) : pow2_length(x, pow2_base_shift(base));
+    // The octal prefix is omitted when the precision already gives a leading zero
+    const bool octal_prefix = (base_padding == 1) && (!use_precision || (zeros <= digits));
+    const bool hex_prefix = (base_padding == 2);
+    const int length = (include_sign ? 1 : 0) + (octal_prefix ? 1 : 0) + (hex_prefix ? 2 : 0) + MAX(zeros, digits);
+    const int padding = width - length;
+    if (sink_discards(sink)) {
+        return MAX(padding, 0) + length;
+    }
+    if (!left_justify) {
+        sink_fill(sink, ' ', padding);
     }
     if (include_sign) {
-        str[written++] = negative ? '-' : '+';
+        sink_putc(sink, negative ? '-' : '+');
     }
-    if (!left_justify) {
-        while (written < width) {
-            str[written++] = ' ';
-        }
+    if (octal_prefix || hex_prefix) {
+        sink_putc(sink, '0');
     }
-    for (int index = written; index > 0; index--) {
-        PUTCHAR(str[index-1]);
+    if (hex_prefix) {
+        sink_putc(sink, uppercase ? 'X' : 'x');
     }
+    sink_fill(sink, '0', zeros - digits);
+    put_digits(sink, x, digits, base, uppercase);
     if (left_justify) {
-        while (written < width) {
-            PUTCHAR(' ');
-            written++;
-        }
+        sink_fill(sink, ' ', padding);
     }
+    const int written = MAX(padding, 0) + length;
     // This function doesn't need to introduce null termination to the buffer
     // This is responsability of its caller
     return written;
 }
 
-// Computes x * radix^exponent
-static double scale_radix_exp(double x, const int radix, int exponent)
+// Largest mantissa that can still receive one more digit without overflowing
+#define DECIMAL_MANTISSA_LIMIT 1000000000000000000ULL // 10^18
+
+// Parses a string into a decimal floating point number (leading white-spaces aren't skipped)
+// If end isn't NULL, the string is parsed at most until end (exclusive), and the characters
+// up to end must be readable, so that digits can be processed 8 at a time
+// Digits that doesn't fit in the mantissa are discarded, but remembered in 'dec'
+// Returns the amount of characters that were consumed, or zero if no digit was found
+static int str_to_decimal(const char *const str, const char *const end, struct Decimal *const dec)
 {
-    if (x == 0.0) {
-        return x;
+    const int base = 10;
+    const int len = (end != NULL) ? (int)(end - str) : INT_MAX;
+    bool dotted = false;
+    bool has_digits = false;
+    int index = 0;
+    dec->mantissa = 0;
+    dec->exponent = 0;
+    dec->negative = false;
+    dec->truncated = false;
+    dec->discarded_digits = 0;
+    dec->first_discarded = NULL;
+    if ((index < len) && ((str[index] == '+') || (str[index] == '-'))) {
+        dec->negative = str[index] == '-';
+        index++;
     }
-    if (exponent < 0) {
-        while (exponent++ != 0) {
-            x /= radix;
+    while ((index < len) && (str[index] != '\0')) {
+        if ((end != NULL) && ((len - index) >= 8) && (dec->mantissa < 10000000000ULL)) {
+            const uint64_t word = load_word(&str[index]);
+            // The mantissa can receive 8 more digits without reaching DECIMAL_MANTISSA_LIMIT
+            if (word_is_eight_digits(word)) {
+                dec->mantissa = 100000000 * dec->mantissa + word_to_eight_digits(word);
+                if (dotted) {
+                    dec->exponent -= 8;
+                }
+                has_digits = true;
+                index += 8;
+                continue;
+            }
         }
-    } else {
-        while (exponent-- != 0) {
-            if (x < -DBL_MAX/radix) {
-                return -HUGE_VAL;
-            } else if (DBL_MAX/radix < x) {
-                return HUGE_VAL;
+        if (isdigit(str[index])) {
+            const int digit = str[index] - '0';
+            if (dec->mantissa < DECIMAL_MANTISSA_LIMIT) {
+                dec->mantissa = (uint64_t)base * dec->mantissa + (uint64_t)digit;
+                if (dotted) {
+                    dec->exponent--;
+                }
+            } else {
+                if (dec->discarded_digits == 0) {
+                    dec->first_discarded = &str[index];
+                }
+                dec->discarded_digits++;
+                dec->truncated = dec->truncated || (digit != 0);
+                if (!dotted) {
+                    dec->exponent++;
+                }
             }
-            x *= radix;
+            has_digits = true;
+        } else if ((str[index] == '.') && !dotted) {
+            dotted = true;
+        } else {
+            break;
         }
+        index++;
     }
-    return x;
-}
-
-LIBCJ_FN long div_remainder_double(const double dividend, const double divisor)
-{
-    const long quotient = (long)(dividend / divisor);
-    const double remainder = dividend - (divisor * (double)quotient);
-    return (long)remainder;
-}
-
-// value must be positive
-LIBCJ_FN long int exponent_form_double(double *const value, const int base)
-{
-    long int exponent = 0;
-    if (*value == 0.0) {
+    if (!has_digits) {
+        dec->negative = false;
         return 0;
     }
-    if ((int)(*value/base) > 0) {
-        while ((int)(*value/base) > 0) {
-            *value = scale_radix_exp(*value, base, -1);
-            exponent++;
+    if ((index < len) && (tolower(str[index]) == 'e')) {
+        int exp_index = index + 1;
+        bool exp_negative = false;
+        int exp = 0;
+        if ((exp_index < len) && ((str[exp_index] == '+') || (str[exp_index] == '-'))) {
+            exp_negative = str[exp_index] == '-';
+            exp_index++;
         }
-    } else {
-        while ((int)(*value) == 0) {
-            *value = scale_radix_exp(*value, base, 1);
-            exponent--;
+        if ((exp_index < len) && isdigit(str[exp_index])) {
+            for (; (exp_index < len) && isdigit(str[exp_index]); exp_index++) {
+                // Exponents this large overflow or underflow anyway
+                if (exp < 100000) {
+                    exp = base * exp + (str[exp_index] - '0');
+                }
+            }
+            dec->exponent += exp_negative ? -exp : exp;
+            index = exp_index;
         }
     }
-    return exponent;
+    return index;
 }
 
-LIBCJ_FN double rouding_double(const double value, const int base, const int decimal_places)
+// Returns floor(exponent * log10(2)), for exponents in the range of long double
+LIBCJ_FN int floor_log10_pow2(const int exponent)
 {
-    const double y = scale_radix_exp(value, base, decimal_places);
-    const double remainder = y - (long)y;
-    if (remainder >= 0.5) {
-        const double value_to_add = scale_radix_exp(1.0, base, -decimal_places);
-        return (value + value_to_add);
+    // 78913 / 2^18 is a little less than log10(2)
+    if (exponent >= 0) {
+        return (exponent * 78913) >> 18;
     }
-    return value;
+    return -(((-exponent) * 78913 + (1 << 18) - 1) >> 18);
 }
 
-// Generic function to convert floating point numbers to string
-// Return the amount of characters that would have been written if we had enough size
-static int double_to_str(char **buf, size_t *const sz,
-    const int width, int precision, enum Fmt_Flags flags, const int base,
-    double value)
+// Powers of ten that fit in 32 bits
+static const uint32_t small_powers_of_ten[] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000,
+};
+
+// Sets the big integer to a 64 bits value
+LIBCJ_FN void big_int_set(struct Big_Int *const a, const uint64_t value)
 {
-    char str[LOCAL_BUFFER_SIZE];
-    const bool negative = value < 0.0;
-    const bool uppercase = (flags & Flag_Upper) != 0;
-    const bool left_justify = (flags & Flag_Minus) != 0;
-    const bool include_sign = negative || ((flags & Flag_Plus) != 0);
-    const bool right_fill_with_zeros = ((base != 16) || precision > 0) && ((flags & Flag_Short) == 0);
-    const int base_padding = (base == 16) ? 2 : 0;
-    const int left_padding = base_padding + (include_sign ? 1 : 0);
-    // Flag_Zero is ignored if Flag_Minus is informed
-    const bool pad_with_zeros = !(flags & Flag_Minus) && (flags & Flag_Zero);
-    const int zeros = pad_with_zeros ? (width-left_padding) : 0;
-    value = negative ? (-value) : value;
-    int written = 0;
-    long int exponent = 0;
-    const double original_value = value;
-    if (precision < 0) { // Default precision
-        precision = (base == 16) ? 13 : 6;
+    a->limbs[0] = (uint32_t)value;
+    a->limbs[1] = (uint32_t)(value >> 32);
+    a->size = (a->limbs[1] != 0) ? 2 : ((a->limbs[0] != 0) ? 1 : 0);
+}
+
+// Copies the limbs in use of b to a
+LIBCJ_FN void big_int_copy(struct Big_Int *const a, const struct Big_Int *const b)
+{
+    a->size = b->size;
+    memcpy(a->limbs, b->limbs, (size_t)b->size * sizeof(b->limbs[0]));
+}
+
+// Computes a = a * factor + addend
+LIBCJ_FN void big_int_mul_add(struct Big_Int *const a, const uint32_t factor, const uint32_t addend)
+{
+    uint64_t carry = addend;
+    for (int i = 0; i < a->size; i++) {
+        carry += (uint64_t)a->limbs[i] * factor;
+        a->limbs[i] = (uint32_t)carry;
+        carry >>= 32;
     }
-    if (flags & (Flag_Exp | Flag_Short)) {
-        exponent = exponent_form_double(&value, base == 16 ? 2 : base);
+    if ((carry != 0) && (a->size < BIG_INT_LIMBS)) {
+        a->limbs[a->size++] = (uint32_t)carry;
     }
-    if (flags & Flag_Short) {
-        if (ABS(exponent) >= 5) {
-            flags |= Flag_Exp;
-        }
-        precision = flags & Flag_Exp ? (precision - 1) : (int)(precision - 1 - exponent);
-        if ((flags & Flag_Exp) == 0) {
-            value = original_value;
-        }
+}
+
+// Computes a = a * 10^exponent
+static void big_int_mul_pow10(struct Big_Int *const a, int exponent)
+{
+    for (; exponent >= 9; exponent -= 9) {
+        big_int_mul_add(a, small_powers_of_ten[9], 0);
     }
-    if (flags & Flag_Exp) {
-        const int exponent_base = 10;
-        const int exponent_length = (base == 10) ? 2 : 1;
-        const bool exponent_negative = exponent < 0;
-        exponent = exponent_negative ? (-exponent) : exponent;
-        while ((exponent > 0) || (written < exponent_length)) {
-            str[written++] = VALUE_TO_CHAR((char)(exponent % exponent_base), uppercase);
-            exponent /= exponent_base;
-        }
-        str[written++] = exponent_negative ? '-' : '+';
-        if (base == 16) {
-            str[written++] = uppercase ? 'P' : 'p';
-        } else {
-            str[written++] = uppercase ? 'E' : 'e';
-        }
+    if (exponent > 0) {
+        big_int_mul_add(a, small_powers_of_ten[exponent], 0);
     }
-    bool has_decimal_chars = false;
-    value = rouding_double(value, base, precision);
-    for (int exp = precision; exp > 0; exp--) {
-        const double y = scale_radix_exp(value, base, exp);
-        char c = (char)div_remainder_double(y, base);
-        if (right_fill_with_zeros || has_decimal_chars || (c != 0)) {
-            str[written++] = VALUE_TO_CHAR(c, uppercase);
-            has_decimal_chars = true;
-        }
+}
+
+// Computes a = a * 2^bits
+static void big_int_shift_left(struct Big_Int *const a, const int bits)
+{
+    const int limbs = bits / 32;
+    const int shift = bits % 32;
+    if (a->size == 0) {
+        return;
     }
-    if (has_decimal_chars) {
-        str[written++] = '.';
+    const int size = MIN(a->size + limbs + 1, BIG_INT_LIMBS);
+    for (int i = size - 1; i >= limbs; i--) {
+        const int src = i - limbs;
+        const uint32_t high = (src < a->size) ? a->limbs[src] : 0;
+        const uint32_t low = ((src > 0) && (src <= a->size)) ? a->limbs[src-1] : 0;
+        a->limbs[i] = (shift == 0) ? high : ((high << shift) | (low >> (32 - shift)));
     }
-    char c = (char)div_remainder_double(value, base);
-    do {
-        str[written++] = VALUE_TO_CHAR(c, uppercase);
-        value = scale_radix_exp(value, base, -1);
-        c = (char)div_remainder_double(value, base);
-    } while (c > 0);
-    while (written < zeros) {
-        str[written++] = '0';
+    for (int i = 0; i < MIN(limbs, size); i++) {
+        a->limbs[i] = 0;
     }
-    if (base_padding) {
-        str[written++] = uppercase ? 'X' : 'x';
-        str[written++] = '0';
+    a->size = size;
+    while ((a->size > 0) && (a->limbs[a->size-1] == 0)) {
+        a->size--;
     }
-    if (include_sign) {
-        str[written++] = negative ? '-' : '+';
+}
+
+// Returns a negative number if a < b, zero if a == b or a positive number if a > b
+LIBCJ_FN int big_int_compare(const struct Big_Int *const a, const struct Big_Int *const b)
+{
+    if (a->size != b->size) {
+        return (a->size < b->size) ? -1 : 1;
     }
-    if (flags & Flag_Space) {
-        str[written++] = ' ';
+    for (int i = a->size - 1; i >= 0; i--) {
+        if (a->limbs[i] != b->limbs[i]) {
+            return (a->limbs[i] < b->limbs[i]) ? -1 : 1;
+        }
     }
-    if (!left_justify) {
-        while (written < width) {
-            str[written++] = ' ';
+    return 0;
+}
+
+// Computes a = a - b, where a must be greater than or equal to b
+LIBCJ_FN void big_int_sub(struct Big_Int *const a, const struct Big_Int *const b)
+{
+    uint64_t borrow = 0;
+    for (int i = 0; i < a->size; i++) {
+        const uint64_t subtrahend = ((i < b->size) ? b->limbs[i] : 0) + borrow;
+        if ((i >= b->size) && (borrow == 0)) {
+            break;
         }
+        borrow = (a->limbs[i] < subtrahend) ? 1 : 0;
+        a->limbs[i] = (uint32_t)((uint64_t)a->limbs[i] - subtrahend);
     }
-    for (int index = written; index > 0; index--) {
-        PUTCHAR(str[index-1]);
+    while ((a->size > 0) && (a->limbs[a->size-1] == 0)) {
+        a->size--;
     }
-    if (left_justify) {
-        while (written < width) {
-            PUTCHAR(' ');
-            written++;
+}
+
+// Returns the amount of bits of the big integer
+LIBCJ_FN int big_int_bit_length(const struct Big_Int *const a)
+{
+    if (a->size == 0) {
+        return 0;
+    }
+    return 32 * (a->size - 1) + bit_length(a->limbs[a->size-1]);
+}
+
+// Returns the bit of the big integer at the given position
+LIBCJ_FN uint64_t big_int_bit(const struct Big_Int *const a, const int index)
+{
+    if ((index < 0) || ((index / 32) >= a->size)) {
+        return 0;
+    }
+    return (a->limbs[index / 32] >> (index % 32)) & 1;
+}
+
+// Checks if any bit of the big integer below the given position is set
+LIBCJ_FN bool big_int_any_bit_below(const struct Big_Int *const a, const int index)
+{
+    for (int i = 0; (i < (index / 32)) && (i < a->size); i++) {
+        if (a->limbs[i] != 0) {
+            return true;
         }
     }
-    // This function doesn't need to introduce null termination to the buffer
-    // This is responsability of its caller
-    return written;
+    return ((index / 32) < a->size) && ((a->limbs[index / 32] & ((1U << (index % 32)) - 1)) != 0);
 }
 
-// Generic function to convert string into double in base 10
-// Returns the amount of characters that were consumed
-// If width is greather than zero, it parses at most width characters
-LIBCJ_FN int str_to_double(const char *const str, int width, double *const value) {
-    const int base = 10;
-    bool dotted = false;
-    int exponent = 0;
-    int index = 0;
-    bool negative = false;
-    *value = 0.0;
-    if (width >= 0) {
-        width += index;
+// Returns 'count' bits (at most 64) of the big integer, starting at the given position
+LIBCJ_FN uint64_t big_int_extract(const struct Big_Int *const a, const int index, const int count)
+{
+    uint64_t bits = 0;
+    for (int i = count - 1; i >= 0; i--) {
+        bits = (bits << 1) | big_int_bit(a, index + i);
     }
-    if ((str[index] == '+') || (str[index] == '-')) {
-        negative = str[index] == '-';
-        index++;
+    return bits;
+}
+
+// Stores in 'value' the big integer D such that the decimal (ignoring its sign) is
+// equal to D * 10^E, and returns E. Discarded digits beyond DECIMAL_MAX_DIGITS aren't
+// stored, 'sticky' is set if any of them isn't zero
+static int decimal_to_big_int(const struct Decimal *const dec, struct Big_Int *const value, bool *const sticky)
+{
+    // The mantissa has 19 digits if any digit was discarded
+    const int max_digits = DECIMAL_MAX_DIGITS - 19;
+    const char *cursor = dec->first_discarded;
+    uint32_t chunk = 0;
+    int chunk_digits = 0;
+    int used_digits = 0;
+    big_int_set(value, dec->mantissa);
+    *sticky = false;
+    if (!dec->truncated) {
+        return dec->exponent;
     }
-    for (; ((width < 0) || (index < width)) && (str[index] != '\0'); index++) {
-        if (isdigit(str[index])) {
-            const int digit = str[index] - '0';
-            if (*value <= DBL_MAX / base) {
-                *value = *value * base + digit;
-            } else {
-                exponent++;
-            }
-            if (dotted) {
-                exponent--;
-            }
-        } else if (str[index] == '.') {
-            if (dotted) {
+    for (int i = 0; i < dec->discarded_digits; cursor++) {
+        if (*cursor == '.') {
+            continue;
+        }
+        const uint32_t digit = (uint32_t)(*cursor - '0');
+        i++;
+        if (used_digits >= max_digits) {
+            if (digit != 0) {
+                *sticky = true;
                 break;
             }
-            dotted = true;
-        } else {
-            break;
+            continue;
         }
-    }
-    if (tolower(str[index]) == 'e') {
-        int exp;
-        const int parsed = str_to_sign_integer(&str[index+1], (width-index-1), &exp);
-        if (parsed > 0) {
-            index += parsed + 1;
-            if (exponent > 0) {
-                exponent = ((INT_MAX - exponent) < exp) ? INT_MAX : (exponent + exp);
-            } else {
-                exponent = (exp < (INT_MIN - exponent)) ? INT_MIN : (exponent + exp);
-            }
+        chunk = 10 * chunk + digit;
+        chunk_digits++;
+        used_digits++;
+        if (chunk_digits == 9) {
+            big_int_mul_add(value, small_powers_of_ten[9], chunk);
+            chunk = 0;
+            chunk_digits = 0;
         }
     }
-    *value = scale_radix_exp(negative ? -(*value) : *value, base, exponent);
-    return index;
+    if (chunk_digits > 0) {
+        big_int_mul_add(value, small_powers_of_ten[chunk_digits], chunk);
+    }
+    return dec->exponent - used_digits;
 }
 
-static int put_string(char **buf, size_t *const sz, const int width, int precision, const bool left_justify, const char *string)
+static NOINLINE_FUNCTION int decimal_compare_halfway(const struct Decimal *const dec, const uint64_t mantissa, const int exponent);
+
+// Converts a decimal to the nearest binary floating point number in the given format
+// (ties to even), using big integers to get an exact result
+// Finite results are normalized, unless they are subnormal
+static void decimal_to_binary(const struct Decimal *const dec, const struct Float_Format *const format, struct Binary_Float *const result)
 {
-    int written = 0;
-    if (string == NULL) {
-        string = "(null)";
+    struct Big_Int r, s;
+    bool sticky;
+    const int precision = format->mantissa_bits;
+    bool round_up = false;
+    uint64_t mantissa = 0;
+    int exponent = 0;
+    result->mantissa = 0;
+    result->exponent = 0;
+    result->negative = dec->negative;
+    result->kind = Float_Finite;
+    if (dec->mantissa == 0) {
+        return;
+    }
+    const int decimal_exponent = decimal_to_big_int(dec, &r, &sticky);
+    // Estimate of the decimal exponent of the leading digit, used to skip the
+    // computations of numbers that certainly overflow or underflow
+    const int magnitude = floor_log10_pow2(big_int_bit_length(&r) - 1) + decimal_exponent;
+    if (magnitude >= floor_log10_pow2(format->max_exponent) + 2) {
+        result->kind = Float_Infinite;
+        return;
     }
-    if ((!left_justify) && (width > 0)) {
-        const int len = (int)strlen(string);
-        int spaces = width - ((precision > 0) ? MIN(len, precision) : len);
-        while (spaces > 0) {
-            PUTCHAR(' ');
-            written++;
-            spaces--;
+    if (magnitude <= floor_log10_pow2(format->min_exponent - precision) - 4) {
+        return;
+    }
+    if (decimal_exponent >= 0) {
+        big_int_mul_pow10(&r, decimal_exponent);
+        const int bits = big_int_bit_length(&r);
+        if (bits <= precision) {
+            mantissa = big_int_extract(&r, 0, bits);
+        } else {
+            exponent = bits - precision;
+            mantissa = big_int_extract(&r, exponent, precision);
+            const bool half = big_int_bit(&r, exponent - 1) != 0;
+            const bool rest = sticky || big_int_any_bit_below(&r, exponent - 1);
+            round_up = half && (rest || ((mantissa & 1) != 0));
+        }
+    } else {
+        big_int_set(&s, 1);
+        big_int_mul_pow10(&s, -decimal_exponent);
+        // Scale r and s, so that s <= r < 2*s and the value is r/s * 2^leading_exponent
+        int leading_exponent = big_int_bit_length(&r) - big_int_bit_length(&s);
+        if (leading_exponent < 0) {
+            big_int_shift_left(&r, -leading_exponent);
+        } else {
+            big_int_shift_left(&s, leading_exponent);
+        }
+        if (big_int_compare(&r, &s) < 0) {
+            big_int_shift_left(&r, 1);
+            leading_exponent--;
+        }
+        // Subnormal numbers have less bits of precision
+        int bits = precision;
+        if (leading_exponent < format->min_exponent) {
+            bits -= format->min_exponent - leading_exponent;
+        }
+        if (bits < 0) {
+            return;
         }
+        // Long division, generating one bit of the quotient at a time
+        for (int i = 0; i < bits; i++) {
+            mantissa <<= 1;
+            if (big_int_compare(&r, &s) >= 0) {
+                big_int_sub(&r, &s);
+                mantissa |= 1;
+            }
+            big_int_shift_left(&r, 1);
+        }
+        // Now r is twice the remainder
+        const int cmp = big_int_compare(&r, &s);
+        round_up = (cmp > 0) || ((cmp == 0) && (sticky || ((mantissa & 1) != 0)));
+        exponent = leading_exponent - bits + 1;
     }
-    while ((*string != '\0') && (precision != 0)) {
-        PUTCHAR(*string);
-        string++;
-        written++;
-        precision--;
+    // The digits beyond DECIMAL_MAX_DIGITS may still reach the halfway point, so it is compared
+    // with all of them. This is only needed when the truncated value was rounded down
+    if (sticky && !round_up) {
+        const int cmp = decimal_compare_halfway(dec, mantissa, exponent);
+        round_up = (cmp > 0) || ((cmp == 0) && ((mantissa & 1) != 0));
     }
-    if ((left_justify) && (width > 0)) {
-        int spaces = width - written;
-        while (spaces > 0) {
-            PUTCHAR(' ');
-            written++;
-            spaces--;
+    if (round_up) {
+        mantissa++;
+        // Rounding may have carried into a new bit (the mantissa may have 64 bits)
+        if ((mantissa == 0) || ((precision < 64) && ((mantissa >> precision) != 0))) {
+            mantissa = 1ULL << (precision - 1);
+            exponent++;
         }
     }
-    return written;
+    // Normalize the mantissa
+    while ((mantissa != 0) && (mantissa < (1ULL << (precision - 1))) && (exponent > (format->min_exponent - precision + 1))) {
+        mantissa <<= 1;
+        exponent--;
+    }
+    if ((exponent + precision - 1) > format->max_exponent) {
+        result->kind = Float_Infinite;
+        return;
+    }
+    result->mantissa = mantissa;
+    result->exponent = exponent;
 }
 
-LIBCJ_FN int parse_fmt_flags(const char *const fmt, enum Fmt_Flags *const flags)
+static const struct Float_Format float_format = {FLT_MANT_DIG, FLT_MIN_EXP - 1, FLT_MAX_EXP - 1};
+static const struct Float_Format double_format = {DBL_MANT_DIG, DBL_MIN_EXP - 1, DBL_MAX_EXP - 1};
+static const struct Float_Format ldouble_format = {LDBL_MANT_DIG, LDBL_MIN_EXP - 1, LDBL_MAX_EXP - 1};
+
+// Returns the bits of a binary floating point number in an IEEE 754 format (with
+// an implicit bit), whose exponent has the given amount of bits
+LIBCJ_FN uint64_t binary_to_ieee_bits(const struct Binary_Float *const value, const struct Float_Format *const format, const int exponent_bits)
 {
-    *flags = Flag_None;
-    int index = 0;
-    for (; fmt[index] != '\0'; index++) {
-        switch (fmt[index]) {
-        case '-': *flags |= Flag_Minus; break;
-        case '+': *flags |= Flag_Plus;  break;
-        case ' ': *flags |= Flag_Space; break;
-        case '#': *flags |= Flag_Hash;  break;
-        case '0': *flags |= Flag_Zero;  break;
-        default: return index;
+    const int fraction_bits = format->mantissa_bits - 1;
+    const uint64_t max_biased_exponent = (1ULL << exponent_bits) - 1;
+    const uint64_t sign = (uint64_t)value->negative << (fraction_bits + exponent_bits);
+    switch (value->kind) {
+    case Float_Infinite:
+        return sign | (max_biased_exponent << fraction_bits);
+    case Float_NaN:
+        return sign | (max_biased_exponent << fraction_bits) | (1ULL << (fraction_bits - 1));
+    case Float_Finite:
+    default:
+        break;
+    }
+    if (value->mantissa < (1ULL << fraction_bits)) { // Subnormal number or zero
+        return sign | value->mantissa;
+    }
+    const uint64_t biased_exponent = (uint64_t)(value->exponent + fraction_bits + 1 - format->min_exponent);
+    return sign | (biased_exponent << fraction_bits) | (value->mantissa & ((1ULL << fraction_bits) - 1));
+}
+
+// Decomposes the bits of a number in an IEEE 754 format (with an implicit bit)
+LIBCJ_FN void ieee_bits_to_binary(const uint64_t bits, const struct Float_Format *const format, const int exponent_bits, struct Binary_Float *const value)
+{
+    const int fraction_bits = format->mantissa_bits - 1;
+    const uint64_t max_biased_exponent = (1ULL << exponent_bits) - 1;
+    const uint64_t fraction = bits & ((1ULL << fraction_bits) - 1);
+    const uint64_t biased_exponent = (bits >> fraction_bits) & max_biased_exponent;
+    value->negative = ((bits >> (fraction_bits + exponent_bits)) & 1) != 0;
+    value->kind = Float_Finite;
+    if (biased_exponent == max_biased_exponent) {
+        value->kind = (fraction != 0) ? Float_NaN : Float_Infinite;
+        value->mantissa = 0;
+        value->exponent = 0;
+    } else if (biased_exponent == 0) { // Subnormal number or zero
+        value->mantissa = fraction;
+        value->exponent = format->min_exponent - fraction_bits;
+    } else {
+        value->mantissa = fraction | (1ULL << fraction_bits);
+        value->exponent = (int)biased_exponent - 1 + format->min_exponent - fraction_bits;
+    }
+}
+
+LIBCJ_FN double binary_to_double(const struct Binary_Float *const value)
+{
+    const uint64_t bits = binary_to_ieee_bits(value, &double_format, 11);
+    double result;
+    memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+LIBCJ_FN void double_to_binary(const double value, struct Binary_Float *const result)
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    ieee_bits_to_binary(bits, &double_format, 11, result);
+}
+
+LIBCJ_FN float binary_to_float(const struct Binary_Float *const value)
+{
+    const uint32_t bits = (uint32_t)binary_to_ieee_bits(value, &float_format, 8);
+    float result;
+    memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+// The x87 extended precision format has a 64 bits mantissa with an explicit integer
+// bit, followed by 15 bits of exponent and the sign bit
+#if (LDBL_MANT_DIG == 64) && (defined(__x86_64__) || defined(__i386__))
+#define LONG_DOUBLE_X87
+#endif
+
+#ifdef LONG_DOUBLE_X87
+#define X87_EXPONENT_MAX 0x7FFF
+// Format of the values produced by long_double_to_binary
+#define LDOUBLE_BINARY_FORMAT (&ldouble_format)
+
+LIBCJ_FN long double binary_to_long_double(const struct Binary_Float *const value)
+{
+    uint8_t bytes[sizeof(long double)] = {0};
+    uint64_t mantissa = value->mantissa;
+    uint64_t sign_exponent = (uint64_t)value->negative << 15;
+    switch (value->kind) {
+    case Float_Infinite:
+        mantissa = 1ULL << 63;
+        sign_exponent |= X87_EXPONENT_MAX;
+        break;
+    case Float_NaN:
+        mantissa = 3ULL << 62;
+        sign_exponent |= X87_EXPONENT_MAX;
+        break;
+    case Float_Finite:
+    default:
+        if (mantissa >= (1ULL << 63)) { // Subnormal numbers and zero have null exponent
+            sign_exponent |= (uint64_t)(value->exponent + 64 - ldouble_format.min_exponent);
         }
+        break;
     }
-    return index;
+    for (int i = 0; i < 8; i++) {
+        bytes[i] = (uint8_t)(mantissa >> (8*i));
+    }
+    bytes[8] = (uint8_t)sign_exponent;
+    bytes[9] = (uint8_t)(sign_exponent >> 8);
+    long double result;
+    memcpy(&result, bytes, sizeof(result));
+    return result;
 }
 
-LIBCJ_FN int parse_width_precision(const char *const fmt, va_list args, int *const width, int *const precision)
+LIBCJ_FN void long_double_to_binary(const long double value, struct Binary_Float *const result)
 {
-    int index = 0;
-    if (fmt[index] == '*') {
-        index++;
-        *width = va_arg(args, int);
+    uint8_t bytes[sizeof(long double)];
+    uint64_t mantissa = 0;
+    memcpy(bytes, &value, sizeof(bytes));
+    for (int i = 0; i < 8; i++) {
+        mantissa |= (uint64_t)bytes[i] << (8*i);
+    }
+    const int biased_exponent = (bytes[8] | (bytes[9] << 8)) & X87_EXPONENT_MAX;
+    result->negative = (bytes[9] & 0x80) != 0;
+    result->kind = Float_Finite;
+    result->mantissa = mantissa;
+    if (biased_exponent == X87_EXPONENT_MAX) {
+        result->kind = ((mantissa << 1) != 0) ? Float_NaN : Float_Infinite;
+        result->mantissa = 0;
+        result->exponent = 0;
+    } else if (biased_exponent == 0) { // Subnormal number or zero
+        result->exponent = ldouble_format.min_exponent - 63;
     } else {
-        index += str_to_natural(&fmt[index], width);
+        result->exponent = biased_exponent - 64 + ldouble_format.min_exponent;
     }
-    if (fmt[index] == '.') {
-        index++;
-        if (fmt[index] == '*') {
-            index++;
-            *precision = va_arg(args, int);
+}
+#else
+// Other long double formats are converted through double, which is exact only when both
+// types are the same, see the note at strtold in libcj.h
+#define LDOUBLE_BINARY_FORMAT (&double_format)
+
+LIBCJ_FN long double binary_to_long_double(const struct Binary_Float *const value)
+{
+    return (long double)binary_to_double(value);
+}
+
+LIBCJ_FN void long_double_to_binary(const long double value, struct Binary_Float *const result)
+{
+    double_to_binary((double)value, result);
+}
+#endif
+
+// Powers of ten that are exactly representable as double
+static const double exact_powers_of_ten[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+#define MAX_EXACT_POWER_OF_TEN 22
+#define MAX_EXACT_DOUBLE_INT   (1ULL << DBL_MANT_DIG)
+
+// Checks if the decimal can be converted with a single exact multiplication or
+// division, which is correctly rounded by the floating point unit
+LIBCJ_FN bool decimal_in_fast_path(const struct Decimal *const dec)
+{
+    return (dec->mantissa <= MAX_EXACT_DOUBLE_INT) &&
+        (-MAX_EXACT_POWER_OF_TEN <= dec->exponent) && (dec->exponent <= MAX_EXACT_POWER_OF_TEN);
+}
+
+// Converts a decimal floating point number to double
+static double decimal_to_double(const struct Decimal *const dec)
+{
+    if (decimal_in_fast_path(dec)) {
+        double value = (double)dec->mantissa;
+        if (dec->exponent < 0) {
+            value /= exact_powers_of_ten[-dec->exponent];
         } else {
-            index += str_to_natural(&fmt[index], precision);
+            value *= exact_powers_of_ten[dec->exponent];
         }
+        return dec->negative ? -value : value;
     }
-    return index;
+    struct Binary_Float value;
+    decimal_to_binary(dec, &double_format, &value);
+    return binary_to_double(&value);
 }
 
-LIBCJ_FN int parse_fmt_specifier(const char *const fmt, enum Fmt_Specifier *const specifier, enum Length_Modifier *const modifier, bool *const uppercase)
+// Converts a decimal floating point number to float
+static float decimal_to_float(const struct Decimal *const dec)
 {
-    int index = 0;
-    *specifier = Fmt_unknown;
-    // Parse the length modifier
-    *modifier = Modifier_None;
-    if (fmt[index] == 'h') {
-        index++;
-        if (fmt[index] == 'h') {
-            index++;
-            *modifier = Modifier_char;
+    // Powers of ten up to 10^10 and integers up to 2^24 are exactly representable as float
+    if ((dec->mantissa <= (1ULL << FLT_MANT_DIG)) && (-10 <= dec->exponent) && (dec->exponent <= 10)) {
+        float value = (float)dec->mantissa;
+        if (dec->exponent < 0) {
+            value /= (float)exact_powers_of_ten[-dec->exponent];
         } else {
-            *modifier = Modifier_short;
+            value *= (float)exact_powers_of_ten[dec->exponent];
         }
-    } else if (fmt[index] == 'l') {
-        index++;
-        if (fmt[index] == 'l') {
-            index++;
-            *modifier = Modifier_llong;
+        return dec->negative ? -value : value;
+    }
+    struct Binary_Float value;
+    decimal_to_binary(dec, &float_format, &value);
+    return binary_to_float(&value);
+}
+
+#ifdef LONG_DOUBLE_X87
+// Powers of ten that are exactly representable as x87 long double
+static const long double exact_powers_of_ten_ldouble[] = {
+    1e0L,  1e1L,  1e2L,  1e3L,  1e4L,  1e5L,  1e6L,  1e7L,  1e8L,  1e9L,
+    1e10L, 1e11L, 1e12L, 1e13L, 1e14L, 1e15L, 1e16L, 1e17L, 1e18L, 1e19L,
+    1e20L, 1e21L, 1e22L, 1e23L, 1e24L, 1e25L, 1e26L, 1e27L,
+};
+
+// Converts a decimal floating point number to long double
+static long double decimal_to_long_double(const struct Decimal *const dec)
+{
+    // Any mantissa is exactly representable in 64 bits, unless digits were discarded
+    if (!dec->truncated && (-27 <= dec->exponent) && (dec->exponent <= 27)) {
+        long double value = (long double)dec->mantissa;
+        if (dec->exponent < 0) {
+            value /= exact_powers_of_ten_ldouble[-dec->exponent];
         } else {
-            *modifier = Modifier_long;
+            value *= exact_powers_of_ten_ldouble[dec->exponent];
         }
-    } else if (fmt[index] == 'L') {
-        index++;
-        *modifier = Modifier_ldouble;
+        return dec->negative ? -value : value;
     }
-    // Parse the format specifier
-    switch (fmt[index]) {
-    // Integers
-    case 'd': *specifier = Fmt_d; break;
-    case 'i': *specifier = Fmt_i; break;
-    case 'u': *specifier = Fmt_u; break;
-    case 'o': *specifier = Fmt_o; break;
-    case 'x':
-    case 'X': *specifier = Fmt_x; break;
-    // Floating points
-    case 'f':
-    case 'F': *specifier = Fmt_f; break;
-    case 'e':
-    case 'E': *specifier = Fmt_e; break;
-    case 'g':
-    case 'G': *specifier = Fmt_g; break;
-    case 'a':
-    case 'A': *specifier = Fmt_a; break;
-    // Others
-    case 'c': *specifier = Fmt_c; break;
-    case 's': *specifier = Fmt_s; break;
-    case 'p': *specifier = Fmt_p; break;
-    case 'n': *specifier = Fmt_n; break;
-    case '%': *specifier = Fmt_percent; break;
+    struct Binary_Float value;
+    decimal_to_binary(dec, &ldouble_format, &value);
+    return binary_to_long_double(&value);
+}
+#else
+static long double decimal_to_long_double(const struct Decimal *const dec)
+{
+    return (long double)decimal_to_double(dec);
+}
+#endif
+
+// Converts a batch of decimals to doubles
+// The fast path is computed for all values without branches, so that the compiler may
+// vectorize the loop, and afterwards the values outside the fast path are fixed up
+static void decimals_to_doubles(const struct Decimal *const decs, const size_t count, double *const values)
+{
+    for (size_t i = 0; i < count; i++) {
+        const int exponent = MAX(-MAX_EXACT_POWER_OF_TEN, MIN(decs[i].exponent, MAX_EXACT_POWER_OF_TEN));
+        const double mantissa = (double)decs[i].mantissa;
+        const double value = (exponent < 0) ?
+            (mantissa / exact_powers_of_ten[-exponent]) :
+            (mantissa * exact_powers_of_ten[exponent]);
+        values[i] = decs[i].negative ? -value : value;
     }
-    if (*specifier == Fmt_unknown) {
-        return 0;
+    for (size_t i = 0; i < count; i++) {
+        if (!decimal_in_fast_path(&decs[i])) {
+            values[i] = decimal_to_double(&decs[i]);
+        }
     }
-    if (uppercase != NULL) {
-        *uppercase = isupper(fmt[index]);
+}
+
+// Computes floor(value / 2^shift), also for negative values
+LIBCJ_FN int floor_shift(const int64_t value, const int shift)
+{
+    if (value >= 0) {
+        return (int)(value >> shift);
     }
-    // Return the amount of characters parsed
-    return (index + 1);
+    return -(int)(((-value) + (1LL << shift) - 1) >> shift);
+}
+
+// Returns the high 64 bits of the 128 bits product a * b, and stores the low bits in 'low'
+LIBCJ_FN uint64_t multiply_high(const uint64_t a, const uint64_t b, uint64_t *const low)
+{
+#ifdef __SIZEOF_INT128__
+    __extension__ typedef unsigned __int128 uint128;
+    const uint128 product = (uint128)a * b;
+    *low = (uint64_t)product;
+    return (uint64_t)(product >> 64);
+#else
+    const uint64_t a_low = (uint32_t)a, a_high = a >> 32;
+    const uint64_t b_low = (uint32_t)b, b_high = b >> 32;
+    const uint64_t low_low = a_low * b_low;
+    const uint64_t high_low = a_high * b_low;
+    const uint64_t low_high = a_low * b_high;
+    const uint64_t middle = (low_low >> 32) + (uint32_t)high_low + (uint32_t)low_high;
+    *low = (middle << 32) | (uint32_t)low_low;
+    return a_high * b_high + (high_low >> 32) + (low_high >> 32) + (middle >> 32);
+#endif
+}
+
+// 128 bits approximations of the powers of ten, used to find the shortest representation of
+// doubles. Each entry is floor(10^k * 2^-r) + 1, where r is chosen so that the most significant
+// bit of the entry is set
+#define SHORTEST_MIN_POW10 (-292)
+#define SHORTEST_MAX_POW10 324
+
+static const uint64_t shortest_powers_of_ten[][2] = {
+    {0xFF77B1FCBEBCDC4F, 0x25E8E89C13BB0F7B}, // -292
+    {0x9FAACF3DF73609B1, 0x77B191618C54E9AD}, // -291
+    {0xC795830D75038C1D, 0xD59DF5B9EF6A2418}, // -290
+    {0xF97AE3D0D2446F25, 0x4B0573286B44AD1E}, // -289
+    {0x9BECCE62836AC577, 0x4EE367F9430AEC33}, // -288
+    {0xC2E801FB244576D5, 0x229C41F793CDA740}, // -287
+    {0xF3A20279ED56D48A, 0x6B43527578C11110}, // -286
+    {0x9845418C345644D6, 0x830A13896B78AAAA}, // -285
+    {0xBE5691EF416BD60C, 0x23CC986BC656D554}, // -284
+    {0xEDEC366B11C6CB8F, 0x2CBFBE86B7EC8AA9}, // -283
+    {0x94B3A202EB1C3F39, 0x7BF7D71432F3D6AA}, // -282
+    {0xB9E08A83A5E34F07, 0xDAF5CCD93FB0CC54}, // -281
+    {0xE858AD248F5C22C9, 0xD1B3400F8F9CFF69}, // -280
+    {0x91376C36D99995BE, 0x23100809B9C21FA2}, // -279
+    {0xB58547448FFFFB2D, 0xABD40A0C2832A78B}, // -278
+    {0xE2E69915B3FFF9F9, 0x16C90C8F323F516D}, // -277
+    {0x8DD01FAD907FFC3B, 0xAE3DA7D97F6792E4}, // -276
+    {0xB1442798F49FFB4A, 0x99CD11CFDF41779D}, // -275
+    {0xDD95317F31C7FA1D, 0x40405643D711D584}, // -274
+    {0x8A7D3EEF7F1CFC52, 0x482835EA666B2573}, // -273
+    {0xAD1C8EAB5EE43B66, 0xDA3243650005EED0}, // -272
+    {0xD863B256369D4A40, 0x90BED43E40076A83}, // -271
+    {0x873E4F75E2224E68, 0x5A7744A6E804A292}, // -270
+    {0xA90DE3535AAAE202, 0x711515D0A205CB37}, // -269
+    {0xD3515C2831559A83, 0x0D5A5B44CA873E04}, // -268
+    {0x8412D9991ED58091, 0xE858790AFE9486C3}, // -267
+    {0xA5178FFF668AE0B6, 0x626E974DBE39A873}, // -266
+    {0xCE5D73FF402D98E3, 0xFB0A3D212DC81290}, // -265
+    {0x80FA687F881C7F8E, 0x7CE66634BC9D0B9A}, // -264
+    {0xA139029F6A239F72, 0x1C1FFFC1EBC44E81}, // -263
+    {0xC987434744AC874E, 0xA327FFB266B56221}, // -262
+    {0xFBE9141915D7A922, 0x4BF1FF9F0062BAA9}, // -261
+    {0x9D71AC8FADA6C9B5, 0x6F773FC3603DB4AA}, // -260
+    {0xC4CE17B399107C22, 0xCB550FB4384D21D4}, // -259
+    {0xF6019DA07F549B2B, 0x7E2A53A146606A49}, // -258
+    {0x99C102844F94E0FB, 0x2EDA7444CBFC426E}, // -257
+    {0xC0314325637A1939, 0xFA911155FEFB5309}, // -256
+    {0xF03D93EEBC589F88, 0x793555AB7EBA27CB}, // -255
+    {0x96267C7535B763B5, 0x4BC1558B2F3458DF}, // -254
+    {0xBBB01B9283253CA2, 0x9EB1AAEDFB016F17}, // -253
+    {0xEA9C227723EE8BCB, 0x465E15A979C1CADD}, // -252
+    {0x92A1958A7675175F, 0x0BFACD89EC191ECA}, // -251
+    {0xB749FAED14125D36, 0xCEF980EC671F667C}, // -250
+    {0xE51C79A85916F484, 0x82B7E12780E7401B}, // -249
+    {0x8F31CC0937AE58D2, 0xD1B2ECB8B0908811}, // -248
+    {0xB2FE3F0B8599EF07, 0x861FA7E6DCB4AA16}, // -247
+    {0xDFBDCECE67006AC9, 0x67A791E093E1D49B}, // -246
+    {0x8BD6A141006042BD, 0xE0C8BB2C5C6D24E1}, // -245
+    {0xAECC49914078536D, 0x58FAE9F773886E19}, // -244
+    {0xDA7F5BF590966848, 0xAF39A475506A899F}, // -243
+    {0x888F99797A5E012D, 0x6D8406C952429604}, // -242
+    {0xAAB37FD7D8F58178, 0xC8E5087BA6D33B84}, // -241
+    {0xD5605FCDCF32E1D6, 0xFB1E4A9A90880A65}, // -240
+    {0x855C3BE0A17FCD26, 0x5CF2EEA09A550680}, // -239
+    {0xA6B34AD8C9DFC06F, 0xF42FAA48C0EA481F}, // -238
+    {0xD0601D8EFC57B08B, 0xF13B94DAF124DA27}, // -237
+    {0x823C12795DB6CE57, 0x76C53D08D6B70859}, // -236
+    {0xA2CB1717B52481ED, 0x54768C4B0C64CA6F}, // -235
+    {0xCB7DDCDDA26DA268, 0xA9942F5DCF7DFD0A}, // -234
+    {0xFE5D54150B090B02, 0xD3F93B35435D7C4D}, // -233
+    {0x9EFA548D26E5A6E1, 0xC47BC5014A1A6DB0}, // -232
+    {0xC6B8E9B0709F109A, 0x359AB6419CA1091C}, // -231
+    {0xF867241C8CC6D4C0, 0xC30163D203C94B63}, // -230
+    {0x9B407691D7FC44F8, 0x79E0DE63425DCF1E}, // -229
+    {0xC21094364DFB5636, 0x985915FC12F542E5}, // -228
+    {0xF294B943E17A2BC4, 0x3E6F5B7B17B2939E}, // -227
+    {0x979CF3CA6CEC5B5A, 0xA705992CEECF9C43}, // -226
+    {0xBD8430BD08277231, 0x50C6FF782A838354}, // -225
+    {0xECE53CEC4A314EBD, 0xA4F8BF5635246429}, // -224
+    {0x940F4613AE5ED136, 0x871B7795E136BE9A}, // -223
+    {0xB913179899F68584, 0x28E2557B59846E40}, // -222
+    {0xE757DD7EC07426E5, 0x331AEADA2FE589D0}, // -221
+    {0x9096EA6F3848984F, 0x3FF0D2C85DEF7622}, // -220
+    {0xB4BCA50B065ABE63, 0x0FED077A756B53AA}, // -219
+    {0xE1EBCE4DC7F16DFB, 0xD3E8495912C62895}, // -218
+    {0x8D3360F09CF6E4BD, 0x64712DD7ABBBD95D}, // -217
+    {0xB080392CC4349DEC, 0xBD8D794D96AACFB4}, // -216
+    {0xDCA04777F541C567, 0xECF0D7A0FC5583A1}, // -215
+    {0x89E42CAAF9491B60, 0xF41686C49DB57245}, // -214
+    {0xAC5D37D5B79B6239, 0x311C2875C522CED6}, // -213
+    {0xD77485CB25823AC7, 0x7D633293366B828C}, // -212
+    {0x86A8D39EF77164BC, 0xAE5DFF9C02033198}, // -211
+    {0xA8530886B54DBDEB, 0xD9F57F830283FDFD}, // -210
+    {0xD267CAA862A12D66, 0xD072DF63C324FD7C}, // -209
+    {0x8380DEA93DA4BC60, 0x4247CB9E59F71E6E}, // -208
+    {0xA46116538D0DEB78, 0x52D9BE85F074E609}, // -207
+    {0xCD795BE870516656, 0x67902E276C921F8C}, // -206
+    {0x806BD9714632DFF6, 0x00BA1CD8A3DB53B7}, // -205
+    {0xA086CFCD97BF97F3, 0x80E8A40ECCD228A5}, // -204
+    {0xC8A883C0FDAF7DF0, 0x6122CD128006B2CE}, // -203
+    {0xFAD2A4B13D1B5D6C, 0x796B805720085F82}, // -202
+    {0x9CC3A6EEC6311A63, 0xCBE3303674053BB1}, // -201
+    {0xC3F490AA77BD60FC, 0xBEDBFC4411068A9D}, // -200
+    {0xF4F1B4D515ACB93B, 0xEE92FB5515482D45}, // -199
+    {0x991711052D8BF3C5, 0x751BDD152D4D1C4B}, // -198
+    {0xBF5CD54678EEF0B6, 0xD262D45A78A0635E}, // -197
+    {0xEF340A98172AACE4, 0x86FB897116C87C35}, // -196
+    {0x9580869F0E7AAC0E, 0xD45D35E6AE3D4DA1}, // -195
+    {0xBAE0A846D2195712, 0x8974836059CCA10A}, // -194
+    {0xE998D258869FACD7, 0x2BD1A438703FC94C}, // -193
+    {0x91FF83775423CC06, 0x7B6306A34627DDD0}, // -192
+    {0xB67F6455292CBF08, 0x1A3BC84C17B1D543}, // -191
+    {0xE41F3D6A7377EECA, 0x20CABA5F1D9E4A94}, // -190
+    {0x8E938662882AF53E, 0x547EB47B7282EE9D}, // -189
+    {0xB23867FB2A35B28D, 0xE99E619A4F23AA44}, // -188
+    {0xDEC681F9F4C31F31, 0x6405FA00E2EC94D5}, // -187
+    {0x8B3C113C38F9F37E, 0xDE83BC408DD3DD05}, // -186
+    {0xAE0B158B4738705E, 0x9624AB50B148D446}, // -185
+    {0xD98DDAEE19068C76, 0x3BADD624DD9B0958}, // -184
+    {0x87F8A8D4CFA417C9, 0xE54CA5D70A80E5D7}, // -183
+    {0xA9F6D30A038D1DBC, 0x5E9FCF4CCD211F4D}, // -182
+    {0xD47487CC8470652B, 0x7647C32000696720}, // -181
+    {0x84C8D4DFD2C63F3B, 0x29ECD9F40041E074}, // -180
+    {0xA5FB0A17C777CF09, 0xF468107100525891}, // -179
+    {0xCF79CC9DB955C2CC, 0x7182148D4066EEB5}, // -178
+    {0x81AC1FE293D599BF, 0xC6F14CD848405531}, // -177
+    {0xA21727DB38CB002F, 0xB8ADA00E5A506A7D}, // -176
+    {0xCA9CF1D206FDC03B, 0xA6D90811F0E4851D}, // -175
+    {0xFD442E4688BD304A, 0x908F4A166D1DA664}, // -174
+    {0x9E4A9CEC15763E2E, 0x9A598E4E043287FF}, // -173
+    {0xC5DD44271AD3CDBA, 0x40EFF1E1853F29FE}, // -172
+    {0xF7549530E188C128, 0xD12BEE59E68EF47D}, // -171
+    {0x9A94DD3E8CF578B9, 0x82BB74F8301958CF}, // -170
+    {0xC13A148E3032D6E7, 0xE36A52363C1FAF02}, // -169
+    {0xF18899B1BC3F8CA1, 0xDC44E6C3CB279AC2}, // -168
+    {0x96F5600F15A7B7E5, 0x29AB103A5EF8C0BA}, // -167
+    {0xBCB2B812DB11A5DE, 0x7415D448F6B6F0E8}, // -166
+    {0xEBDF661791D60F56, 0x111B495B3464AD22}, // -165
+    {0x936B9FCEBB25C995, 0xCAB10DD900BEEC35}, // -164
+    {0xB84687C269EF3BFB, 0x3D5D514F40EEA743}, // -163
+    {0xE65829B3046B0AFA, 0x0CB4A5A3112A5113}, // -162
+    {0x8FF71A0FE2C2E6DC, 0x47F0E785EABA72AC}, // -161
+    {0xB3F4E093DB73A093, 0x59ED216765690F57}, // -160
+    {0xE0F218B8D25088B8, 0x306869C13EC3532D}, // -159
+    {0x8C974F7383725573, 0x1E414218C73A13FC}, // -158
+    {0xAFBD2350644EEACF, 0xE5D1929EF90898FB}, // -157
+    {0xDBAC6C247D62A583, 0xDF45F746B74ABF3A}, // -156
+    {0x894BC396CE5DA772, 0x6B8BBA8C328EB784}, // -155
+    {0xAB9EB47C81F5114F, 0x066EA92F3F326565}, // -154
+    {0xD686619BA27255A2, 0xC80A537B0EFEFEBE}, // -153
+    {0x8613FD0145877585, 0xBD06742CE95F5F37}, // -152
+    {0xA798FC4196E952E7, 0x2C48113823B73705}, // -151
+    {0xD17F3B51FCA3A7A0, 0xF75A15862CA504C6}, // -150
+    {0x82EF85133DE648C4, 0x9A984D73DBE722FC}, // -149
+    {0xA3AB66580D5FDAF5, 0xC13E60D0D2E0EBBB}, // -148
+    {0xCC963FEE10B7D1B3, 0x318DF905079926A9}, // -147
+    {0xFFBBCFE994E5C61F, 0xFDF17746497F7053}, // -146
+    {0x9FD561F1FD0F9BD3, 0xFEB6EA8BEDEFA634}, // -145
+    {0xC7CABA6E7C5382C8, 0xFE64A52EE96B8FC1}, // -144
+    {0xF9BD690A1B68637B, 0x3DFDCE7AA3C673B1}, // -143
+    {0x9C1661A651213E2D, 0x06BEA10CA65C084F}, // -142
+    {0xC31BFA0FE5698DB8, 0x486E494FCFF30A63}, // -141
+    {0xF3E2F893DEC3F126, 0x5A89DBA3C3EFCCFB}, // -140
+    {0x986DDB5C6B3A76B7, 0xF89629465A75E01D}, // -139
+    {0xBE89523386091465, 0xF6BBB397F1135824}, // -138
+    {0xEE2BA6C0678B597F, 0x746AA07DED582E2D}, // -137
+    {0x94DB483840B717EF, 0xA8C2A44EB4571CDD}, // -136
+    {0xBA121A4650E4DDEB, 0x92F34D62616CE414}, // -135
+    {0xE896A0D7E51E1566, 0x77B020BAF9C81D18}, // -134
+    {0x915E2486EF32CD60, 0x0ACE1474DC1D122F}, // -133
+    {0xB5B5ADA8AAFF80B8, 0x0D819992132456BB}, // -132
+    {0xE3231912D5BF60E6, 0x10E1FFF697ED6C6A}, // -131
+    {0x8DF5EFABC5979C8F, 0xCA8D3FFA1EF463C2}, // -130
+    {0xB1736B96B6FD83B3, 0xBD308FF8A6B17CB3}, // -129
+    {0xDDD0467C64BCE4A0, 0xAC7CB3F6D05DDBDF}, // -128
+    {0x8AA22C0DBEF60EE4, 0x6BCDF07A423AA96C}, // -127
+    {0xAD4AB7112EB3929D, 0x86C16C98D2C953C7}, // -126
+    {0xD89D64D57A607744, 0xE871C7BF077BA8B8}, // -125
+    {0x87625F056C7C4A8B, 0x11471CD764AD4973}, // -124
+    {0xA93AF6C6C79B5D2D, 0xD598E40D3DD89BD0}, // -123
+    {0xD389B47879823479, 0x4AFF1D108D4EC2C4}, // -122
+    {0x843610CB4BF160CB, 0xCEDF722A585139BB}, // -121
+    {0xA54394FE1EEDB8FE, 0xC2974EB4EE658829}, // -120
+    {0xCE947A3DA6A9273E, 0x733D226229FEEA33}, // -119
+    {0x811CCC668829B887, 0x0806357D5A3F5260}, // -118
+    {0xA163FF802A3426A8, 0xCA07C2DCB0CF26F8}, // -117
+    {0xC9BCFF6034C13052, 0xFC89B393DD02F0B6}, // -116
+    {0xFC2C3F3841F17C67, 0xBBAC2078D443ACE3}, // -115
+    {0x9D9BA7832936EDC0, 0xD54B944B84AA4C0E}, // -114
+    {0xC5029163F384A931, 0x0A9E795E65D4DF12}, // -113
+    {0xF64335BCF065D37D, 0x4D4617B5FF4A16D6}, // -112
+    {0x99EA0196163FA42E, 0x504BCED1BF8E4E46}, // -111
+    {0xC06481FB9BCF8D39, 0xE45EC2862F71E1D7}, // -110
+    {0xF07DA27A82C37088, 0x5D767327BB4E5A4D}, // -109
+    {0x964E858C91BA2655, 0x3A6A07F8D510F870}, // -108
+    {0xBBE226EFB628AFEA, 0x890489F70A55368C}, // -107
+    {0xEADAB0ABA3B2DBE5, 0x2B45AC74CCEA842F}, // -106
+    {0x92C8AE6B464FC96F, 0x3B0B8BC90012929E}, // -105
+    {0xB77ADA0617E3BBCB, 0x09CE6EBB40173745}, // -104
+    {0xE55990879DDCAABD, 0xCC420A6A101D0516}, // -103
+    {0x8F57FA54C2A9EAB6, 0x9FA946824A12232E}, // -102
+    {0xB32DF8E9F3546564, 0x47939822DC96ABFA}, // -101
+    {0xDFF9772470297EBD, 0x59787E2B93BC56F8}, // -100
+    {0x8BFBEA76C619EF36, 0x57EB4EDB3C55B65B}, // -99
+    {0xAEFAE51477A06B03, 0xEDE622920B6B23F2}, // -98
+    {0xDAB99E59958885C4, 0xE95FAB368E45ECEE}, // -97
+    {0x88B402F7FD75539B, 0x11DBCB0218EBB415}, // -96
+    {0xAAE103B5FCD2A881, 0xD652BDC29F26A11A}, // -95
+    {0xD59944A37C0752A2, 0x4BE76D3346F04960}, // -94
+    {0x857FCAE62D8493A5, 0x6F70A4400C562DDC}, // -93
+    {0xA6DFBD9FB8E5B88E, 0xCB4CCD500F6BB953}, // -92
+    {0xD097AD07A71F26B2, 0x7E2000A41346A7A8}, // -91
+    {0x825ECC24C873782F, 0x8ED400668C0C28C9}, // -90
+    {0xA2F67F2DFA90563B, 0x728900802F0F32FB}, // -89
+    {0xCBB41EF979346BCA, 0x4F2B40A03AD2FFBA}, // -88
+    {0xFEA126B7D78186BC, 0xE2F610C84987BFA9}, // -87
+    {0x9F24B832E6B0F436, 0x0DD9CA7D2DF4D7CA}, // -86
+    {0xC6EDE63FA05D3143, 0x91503D1C79720DBC}, // -85
+    {0xF8A95FCF88747D94, 0x75A44C6397CE912B}, // -84
+    {0x9B69DBE1B548CE7C, 0xC986AFBE3EE11ABB}, // -83
+    {0xC24452DA229B021B, 0xFBE85BADCE996169}, // -82
+    {0xF2D56790AB41C2A2, 0xFAE27299423FB9C4}, // -81
+    {0x97C560BA6B0919A5, 0xDCCD879FC967D41B}, // -80
+    {0xBDB6B8E905CB600F, 0x5400E987BBC1C921}, // -79
+    {0xED246723473E3813, 0x290123E9AAB23B69}, // -78
+    {0x9436C0760C86E30B, 0xF9A0B6720AAF6522}, // -77
+    {0xB94470938FA89BCE, 0xF808E40E8D5B3E6A}, // -76
+    {0xE7958CB87392C2C2, 0xB60B1D1230B20E05}, // -75
+    {0x90BD77F3483BB9B9, 0xB1C6F22B5E6F48C3}, // -74
+    {0xB4ECD5F01A4AA828, 0x1E38AEB6360B1AF4}, // -73
+    {0xE2280B6C20DD5232, 0x25C6DA63C38DE1B1}, // -72
+    {0x8D590723948A535F, 0x579C487E5A38AD0F}, // -71
+    {0xB0AF48EC79ACE837, 0x2D835A9DF0C6D852}, // -70
+    {0xDCDB1B2798182244, 0xF8E431456CF88E66}, // -69
+    {0x8A08F0F8BF0F156B, 0x1B8E9ECB641B5900}, // -68
+    {0xAC8B2D36EED2DAC5, 0xE272467E3D222F40}, // -67
+    {0xD7ADF884AA879177, 0x5B0ED81DCC6ABB10}, // -66
+    {0x86CCBB52EA94BAEA, 0x98E947129FC2B4EA}, // -65
+    {0xA87FEA27A539E9A5, 0x3F2398D747B36225}, // -64
+    {0xD29FE4B18E88640E, 0x8EEC7F0D19A03AAE}, // -63
+    {0x83A3EEEEF9153E89, 0x1953CF68300424AD}, // -62
+    {0xA48CEAAAB75A8E2B, 0x5FA8C3423C052DD8}, // -61
+    {0xCDB02555653131B6, 0x3792F412CB06794E}, // -60
+    {0x808E17555F3EBF11, 0xE2BBD88BBEE40BD1}, // -59
+    {0xA0B19D2AB70E6ED6, 0x5B6ACEAEAE9D0EC5}, // -58
+    {0xC8DE047564D20A8B, 0xF245825A5A445276}, // -57
+    {0xFB158592BE068D2E, 0xEED6E2F0F0D56713}, // -56
+    {0x9CED737BB6C4183D, 0x55464DD69685606C}, // -55
+    {0xC428D05AA4751E4C, 0xAA97E14C3C26B887}, // -54
+    {0xF53304714D9265DF, 0xD53DD99F4B3066A9}, // -53
+    {0x993FE2C6D07B7FAB, 0xE546A8038EFE402A}, // -52
+    {0xBF8FDB78849A5F96, 0xDE98520472BDD034}, // -51
+    {0xEF73D256A5C0F77C, 0x963E66858F6D4441}, // -50
+    {0x95A8637627989AAD, 0xDDE7001379A44AA9}, // -49
+    {0xBB127C53B17EC159, 0x5560C018580D5D53}, // -48
+    {0xE9D71B689DDE71AF, 0xAAB8F01E6E10B4A7}, // -47
+    {0x9226712162AB070D, 0xCAB3961304CA70E9}, // -46
+    {0xB6B00D69BB55C8D1, 0x3D607B97C5FD0D23}, // -45
+    {0xE45C10C42A2B3B05, 0x8CB89A7DB77C506B}, // -44
+    {0x8EB98A7A9A5B04E3, 0x77F3608E92ADB243}, // -43
+    {0xB267ED1940F1C61C, 0x55F038B237591ED4}, // -42
+    {0xDF01E85F912E37A3, 0x6B6C46DEC52F6689}, // -41
+    {0x8B61313BBABCE2C6, 0x2323AC4B3B3DA016}, // -40
+    {0xAE397D8AA96C1B77, 0xABEC975E0A0D081B}, // -39
+    {0xD9C7DCED53C72255, 0x96E7BD358C904A22}, // -38
+    {0x881CEA14545C7575, 0x7E50D64177DA2E55}, // -37
+    {0xAA242499697392D2, 0xDDE50BD1D5D0B9EA}, // -36
+    {0xD4AD2DBFC3D07787, 0x955E4EC64B44E865}, // -35
+    {0x84EC3C97DA624AB4, 0xBD5AF13BEF0B113F}, // -34
+    {0xA6274BBDD0FADD61, 0xECB1AD8AEACDD58F}, // -33
+    {0xCFB11EAD453994BA, 0x67DE18EDA5814AF3}, // -32
+    {0x81CEB32C4B43FCF4, 0x80EACF948770CED8}, // -31
+    {0xA2425FF75E14FC31, 0xA1258379A94D028E}, // -30
+    {0xCAD2F7F5359A3B3E, 0x096EE45813A04331}, // -29
+    {0xFD87B5F28300CA0D, 0x8BCA9D6E188853FD}, // -28
+    {0x9E74D1B791E07E48, 0x775EA264CF55347E}, // -27
+    {0xC612062576589DDA, 0x95364AFE032A819E}, // -26
+    {0xF79687AED3EEC551, 0x3A83DDBD83F52205}, // -25
+    {0x9ABE14CD44753B52, 0xC4926A9672793543}, // -24
+    {0xC16D9A0095928A27, 0x75B7053C0F178294}, // -23
+    {0xF1C90080BAF72CB1, 0x5324C68B12DD6339}, // -22
+    {0x971DA05074DA7BEE, 0xD3F6FC16EBCA5E04}, // -21
+    {0xBCE5086492111AEA, 0x88F4BB1CA6BCF585}, // -20
+    {0xEC1E4A7DB69561A5, 0x2B31E9E3D06C32E6}, // -19
+    {0x9392EE8E921D5D07, 0x3AFF322E62439FD0}, // -18
+    {0xB877AA3236A4B449, 0x09BEFEB9FAD487C3}, // -17
+    {0xE69594BEC44DE15B, 0x4C2EBE687989A9B4}, // -16
+    {0x901D7CF73AB0ACD9, 0x0F9D37014BF60A11}, // -15
+    {0xB424DC35095CD80F, 0x538484C19EF38C95}, // -14
+    {0xE12E13424BB40E13, 0x2865A5F206B06FBA}, // -13
+    {0x8CBCCC096F5088CB, 0xF93F87B7442E45D4}, // -12
+    {0xAFEBFF0BCB24AAFE, 0xF78F69A51539D749}, // -11
+    {0xDBE6FECEBDEDD5BE, 0xB573440E5A884D1C}, // -10
+    {0x89705F4136B4A597, 0x31680A88F8953031}, // -9
+    {0xABCC77118461CEFC, 0xFDC20D2B36BA7C3E}, // -8
+    {0xD6BF94D5E57A42BC, 0x3D32907604691B4D}, // -7
+    {0x8637BD05AF6C69B5, 0xA63F9A49C2C1B110}, // -6
+    {0xA7C5AC471B478423, 0x0FCF80DC33721D54}, // -5
+    {0xD1B71758E219652B, 0xD3C36113404EA4A9}, // -4
+    {0x83126E978D4FDF3B, 0x645A1CAC083126EA}, // -3
+    {0xA3D70A3D70A3D70A, 0x3D70A3D70A3D70A4}, // -2
+    {0xCCCCCCCCCCCCCCCC, 0xCCCCCCCCCCCCCCCD}, // -1
+    {0x8000000000000000, 0x0000000000000001}, // 0
+    {0xA000000000000000, 0x0000000000000001}, // 1
+    {0xC800000000000000, 0x0000000000000001}, // 2
+    {0xFA00000000000000, 0x0000000000000001}, // 3
+    {0x9C40000000000000, 0x0000000000000001}, // 4
+    {0xC350000000000000, 0x0000000000000001}, // 5
+    {0xF424000000000000, 0x0000000000000001}, // 6
+    {0x9896800000000000, 0x0000000000000001}, // 7
+    {0xBEBC200000000000, 0x0000000000000001}, // 8
+    {0xEE6B280000000000, 0x0000000000000001}, // 9
+    {0x9502F90000000000, 0x0000000000000001}, // 10
+    {0xBA43B74000000000, 0x0000000000000001}, // 11
+    {0xE8D4A51000000000, 0x0000000000000001}, // 12
+    {0x9184E72A00000000, 0x0000000000000001}, // 13
+    {0xB5E620F480000000, 0x0000000000000001}, // 14
+    {0xE35FA931A0000000, 0x0000000000000001}, // 15
+    {0x8E1BC9BF04000000, 0x0000000000000001}, // 16
+    {0xB1A2BC2EC5000000, 0x0000000000000001}, // 17
+    {0xDE0B6B3A76400000, 0x0000000000000001}, // 18
+    {0x8AC7230489E80000, 0x0000000000000001}, // 19
+    {0xAD78EBC5AC620000, 0x0000000000000001}, // 20
+    {0xD8D726B7177A8000, 0x0000000000000001}, // 21
+    {0x878678326EAC9000, 0x0000000000000001}, // 22
+    {0xA968163F0A57B400, 0x0000000000000001}, // 23
+    {0xD3C21BCECCEDA100, 0x0000000000000001}, // 24
+    {0x84595161401484A0, 0x0000000000000001}, // 25
+    {0xA56FA5B99019A5C8, 0x0000000000000001}, // 26
+    {0xCECB8F27F4200F3A, 0x0000000000000001}, // 27
+    {0x813F3978F8940984, 0x4000000000000001}, // 28
+    {0xA18F07D736B90BE5, 0x5000000000000001}, // 29
+    {0xC9F2C9CD04674EDE, 0xA400000000000001}, // 30
+    {0xFC6F7C4045812296, 0x4D00000000000001}, // 31
+    {0x9DC5ADA82B70B59D, 0xF020000000000001}, // 32
+    {0xC5371912364CE305, 0x6C28000000000001}, // 33
+    {0xF684DF56C3E01BC6, 0xC732000000000001}, // 34
+    {0x9A130B963A6C115C, 0x3C7F400000000001}, // 35
+    {0xC097CE7BC90715B3, 0x4B9F100000000001}, // 36
+    {0xF0BDC21ABB48DB20, 0x1E86D40000000001}, // 37
+    {0x96769950B50D88F4, 0x1314448000000001}, // 38
+    {0xBC143FA4E250EB31, 0x17D955A000000001}, // 39
+    {0xEB194F8E1AE525FD, 0x5DCFAB0800000001}, // 40
+    {0x92EFD1B8D0CF37BE, 0x5AA1CAE500000001}, // 41
+    {0xB7ABC627050305AD, 0xF14A3D9E40000001}, // 42
+    {0xE596B7B0C643C719, 0x6D9CCD05D0000001}, // 43
+    {0x8F7E32CE7BEA5C6F, 0xE4820023A2000001}, // 44
+    {0xB35DBF821AE4F38B, 0xDDA2802C8A800001}, // 45
+    {0xE0352F62A19E306E, 0xD50B2037AD200001}, // 46
+    {0x8C213D9DA502DE45, 0x4526F422CC340001}, // 47
+    {0xAF298D050E4395D6, 0x9670B12B7F410001}, // 48
+    {0xDAF3F04651D47B4C, 0x3C0CDD765F114001}, // 49
+    {0x88D8762BF324CD0F, 0xA5880A69FB6AC801}, // 50
+    {0xAB0E93B6EFEE0053, 0x8EEA0D047A457A01}, // 51
+    {0xD5D238A4ABE98068, 0x72A4904598D6D881}, // 52
+    {0x85A36366EB71F041, 0x47A6DA2B7F864751}, // 53
+    {0xA70C3C40A64E6C51, 0x999090B65F67D925}, // 54
+    {0xD0CF4B50CFE20765, 0xFFF4B4E3F741CF6E}, // 55
+    {0x82818F1281ED449F, 0xBFF8F10E7A8921A5}, // 56
+    {0xA321F2D7226895C7, 0xAFF72D52192B6A0E}, // 57
+    {0xCBEA6F8CEB02BB39, 0x9BF4F8A69F764491}, // 58
+    {0xFEE50B7025C36A08, 0x02F236D04753D5B5}, // 59
+    {0x9F4F2726179A2245, 0x01D762422C946591}, // 60
+    {0xC722F0EF9D80AAD6, 0x424D3AD2B7B97EF6}, // 61
+    {0xF8EBAD2B84E0D58B, 0xD2E0898765A7DEB3}, // 62
+    {0x9B934C3B330C8577, 0x63CC55F49F88EB30}, // 63
+    {0xC2781F49FFCFA6D5, 0x3CBF6B71C76B25FC}, // 64
+    {0xF316271C7FC3908A, 0x8BEF464E3945EF7B}, // 65
+    {0x97EDD871CFDA3A56, 0x97758BF0E3CBB5AD}, // 66
+    {0xBDE94E8E43D0C8EC, 0x3D52EEED1CBEA318}, // 67
+    {0xED63A231D4C4FB27, 0x4CA7AAA863EE4BDE}, // 68
+    {0x945E455F24FB1CF8, 0x8FE8CAA93E74EF6B}, // 69
+    {0xB975D6B6EE39E436, 0xB3E2FD538E122B45}, // 70
+    {0xE7D34C64A9C85D44, 0x60DBBCA87196B617}, // 71
+    {0x90E40FBEEA1D3A4A, 0xBC8955E946FE31CE}, // 72
+    {0xB51D13AEA4A488DD, 0x6BABAB6398BDBE42}, // 73
+    {0xE264589A4DCDAB14, 0xC696963C7EED2DD2}, // 74
+    {0x8D7EB76070A08AEC, 0xFC1E1DE5CF543CA3}, // 75
+    {0xB0DE65388CC8ADA8, 0x3B25A55F43294BCC}, // 76
+    {0xDD15FE86AFFAD912, 0x49EF0EB713F39EBF}, // 77
+    {0x8A2DBF142DFCC7AB, 0x6E3569326C784338}, // 78
+    {0xACB92ED9397BF996, 0x49C2C37F07965405}, // 79
+    {0xD7E77A8F87DAF7FB, 0xDC33745EC97BE907}, // 80
+    {0x86F0AC99B4E8DAFD, 0x69A028BB3DED71A4}, // 81
+    {0xA8ACD7C0222311BC, 0xC40832EA0D68CE0D}, // 82
+    {0xD2D80DB02AABD62B, 0xF50A3FA490C30191}, // 83
+    {0x83C7088E1AAB65DB, 0x792667C6DA79E0FB}, // 84
+    {0xA4B8CAB1A1563F52, 0x577001B891185939}, // 85
+    {0xCDE6FD5E09ABCF26, 0xED4C0226B55E6F87}, // 86
+    {0x80B05E5AC60B6178, 0x544F8158315B05B5}, // 87
+    {0xA0DC75F1778E39D6, 0x696361AE3DB1C722}, // 88
+    {0xC913936DD571C84C, 0x03BC3A19CD1E38EA}, // 89
+    {0xFB5878494ACE3A5F, 0x04AB48A04065C724}, // 90
+    {0x9D174B2DCEC0E47B, 0x62EB0D64283F9C77}, // 91
+    {0xC45D1DF942711D9A, 0x3BA5D0BD324F8395}, // 92
+    {0xF5746577930D6500, 0xCA8F44EC7EE3647A}, // 93
+    {0x9968BF6ABBE85F20, 0x7E998B13CF4E1ECC}, // 94
+    {0xBFC2EF456AE276E8, 0x9E3FEDD8C321A67F}, // 95
+    {0xEFB3AB16C59B14A2, 0xC5CFE94EF3EA101F}, // 96
+    {0x95D04AEE3B80ECE5, 0xBBA1F1D158724A13}, // 97
+    {0xBB445DA9CA61281F, 0x2A8A6E45AE8EDC98}, // 98
+    {0xEA1575143CF97226, 0xF52D09D71A3293BE}, // 99
+    {0x924D692CA61BE758, 0x593C2626705F9C57}, // 100
+    {0xB6E0C377CFA2E12E, 0x6F8B2FB00C77836D}, // 101
+    {0xE498F455C38B997A, 0x0B6DFB9C0F956448}, // 102
+    {0x8EDF98B59A373FEC, 0x4724BD4189BD5EAD}, // 103
+    {0xB2977EE300C50FE7, 0x58EDEC91EC2CB658}, // 104
+    {0xDF3D5E9BC0F653E1, 0x2F2967B66737E3EE}, // 105
+    {0x8B865B215899F46C, 0xBD79E0D20082EE75}, // 106
+    {0xAE67F1E9AEC07187, 0xECD8590680A3AA12}, // 107
+    {0xDA01EE641A708DE9, 0xE80E6F4820CC9496}, // 108
+    {0x884134FE908658B2, 0x3109058D147FDCDE}, // 109
+    {0xAA51823E34A7EEDE, 0xBD4B46F0599FD416}, // 110
+    {0xD4E5E2CDC1D1EA96, 0x6C9E18AC7007C91B}, // 111
+    {0x850FADC09923329E, 0x03E2CF6BC604DDB1}, // 112
+    {0xA6539930BF6BFF45, 0x84DB8346B786151D}, // 113
+    {0xCFE87F7CEF46FF16, 0xE612641865679A64}, // 114
+    {0x81F14FAE158C5F6E, 0x4FCB7E8F3F60C07F}, // 115
+    {0xA26DA3999AEF7749, 0xE3BE5E330F38F09E}, // 116
+    {0xCB090C8001AB551C, 0x5CADF5BFD3072CC6}, // 117
+    {0xFDCB4FA002162A63, 0x73D9732FC7C8F7F7}, // 118
+    {0x9E9F11C4014DDA7E, 0x2867E7FDDCDD9AFB}, // 119
+    {0xC646D63501A1511D, 0xB281E1FD541501B9}, // 120
+    {0xF7D88BC24209A565, 0x1F225A7CA91A4227}, // 121
+    {0x9AE757596946075F, 0x3375788DE9B06959}, // 122
+    {0xC1A12D2FC3978937, 0x0052D6B1641C83AF}, // 123
+    {0xF209787BB47D6B84, 0xC0678C5DBD23A49B}, // 124
+    {0x9745EB4D50CE6332, 0xF840B7BA963646E1}, // 125
+    {0xBD176620A501FBFF, 0xB650E5A93BC3D899}, // 126
+    {0xEC5D3FA8CE427AFF, 0xA3E51F138AB4CEBF}, // 127
+    {0x93BA47C980E98CDF, 0xC66F336C36B10138}, // 128
+    {0xB8A8D9BBE123F017, 0xB80B0047445D4185}, // 129
+    {0xE6D3102AD96CEC1D, 0xA60DC059157491E6}, // 130
+    {0x9043EA1AC7E41392, 0x87C89837AD68DB30}, // 131
+    {0xB454E4A179DD1877, 0x29BABE4598C311FC}, // 132
+    {0xE16A1DC9D8545E94, 0xF4296DD6FEF3D67B}, // 133
+    {0x8CE2529E2734BB1D, 0x1899E4A65F58660D}, // 134
+    {0xB01AE745B101E9E4, 0x5EC05DCFF72E7F90}, // 135
+    {0xDC21A1171D42645D, 0x76707543F4FA1F74}, // 136
+    {0x899504AE72497EBA, 0x6A06494A791C53A9}, // 137
+    {0xABFA45DA0EDBDE69, 0x0487DB9D17636893}, // 138
+    {0xD6F8D7509292D603, 0x45A9D2845D3C42B7}, // 139
+    {0x865B86925B9BC5C2, 0x0B8A2392BA45A9B3}, // 140
+    {0xA7F26836F282B732, 0x8E6CAC7768D7141F}, // 141
+    {0xD1EF0244AF2364FF, 0x3207D795430CD927}, // 142
+    {0x8335616AED761F1F, 0x7F44E6BD49E807B9}, // 143
+    {0xA402B9C5A8D3A6E7, 0x5F16206C9C6209A7}, // 144
+    {0xCD036837130890A1, 0x36DBA887C37A8C10}, // 145
+    {0x802221226BE55A64, 0xC2494954DA2C978A}, // 146
+    {0xA02AA96B06DEB0FD, 0xF2DB9BAA10B7BD6D}, // 147
+    {0xC83553C5C8965D3D, 0x6F92829494E5ACC8}, // 148
+    {0xFA42A8B73ABBF48C, 0xCB772339BA1F17FA}, // 149
+    {0x9C69A97284B578D7, 0xFF2A760414536EFC}, // 150
+    {0xC38413CF25E2D70D, 0xFEF5138519684ABB}, // 151
+    {0xF46518C2EF5B8CD1, 0x7EB258665FC25D6A}, // 152
+    {0x98BF2F79D5993802, 0xEF2F773FFBD97A62}, // 153
+    {0xBEEEFB584AFF8603, 0xAAFB550FFACFD8FB}, // 154
+    {0xEEAABA2E5DBF6784, 0x95BA2A53F983CF39}, // 155
+    {0x952AB45CFA97A0B2, 0xDD945A747BF26184}, // 156
+    {0xBA756174393D88DF, 0x94F971119AEEF9E5}, // 157
+    {0xE912B9D1478CEB17, 0x7A37CD5601AAB85E}, // 158
+    {0x91ABB422CCB812EE, 0xAC62E055C10AB33B}, // 159
+    {0xB616A12B7FE617AA, 0x577B986B314D600A}, // 160
+    {0xE39C49765FDF9D94, 0xED5A7E85FDA0B80C}, // 161
+    {0x8E41ADE9FBEBC27D, 0x14588F13BE847308}, // 162
+    {0xB1D219647AE6B31C, 0x596EB2D8AE258FC9}, // 163
+    {0xDE469FBD99A05FE3, 0x6FCA5F8ED9AEF3BC}, // 164
+    {0x8AEC23D680043BEE, 0x25DE7BB9480D5855}, // 165
+    {0xADA72CCC20054AE9, 0xAF561AA79A10AE6B}, // 166
+    {0xD910F7FF28069DA4, 0x1B2BA1518094DA05}, // 167
+    {0x87AA9AFF79042286, 0x90FB44D2F05D0843}, // 168
+    {0xA99541BF57452B28, 0x353A1607AC744A54}, // 169
+    {0xD3FA922F2D1675F2, 0x42889B8997915CE9}, // 170
+    {0x847C9B5D7C2E09B7, 0x69956135FEBADA12}, // 171
+    {0xA59BC234DB398C25, 0x43FAB9837E699096}, // 172
+    {0xCF02B2C21207EF2E, 0x94F967E45E03F4BC}, // 173
+    {0x8161AFB94B44F57D, 0x1D1BE0EEBAC278F6}, // 174
+    {0xA1BA1BA79E1632DC, 0x6462D92A69731733}, // 175
+    {0xCA28A291859BBF93, 0x7D7B8F7503CFDCFF}, // 176
+    {0xFCB2CB35E702AF78, 0x5CDA735244C3D43F}, // 177
+    {0x9DEFBF01B061ADAB, 0x3A0888136AFA64A8}, // 178
+    {0xC56BAEC21C7A1916, 0x088AAA1845B8FDD1}, // 179
+    {0xF6C69A72A3989F5B, 0x8AAD549E57273D46}, // 180
+    {0x9A3C2087A63F6399, 0x36AC54E2F678864C}, // 181
+    {0xC0CB28A98FCF3C7F, 0x84576A1BB416A7DE}, // 182
+    {0xF0FDF2D3F3C30B9F, 0x656D44A2A11C51D6}, // 183
+    {0x969EB7C47859E743, 0x9F644AE5A4B1B326}, // 184
+    {0xBC4665B596706114, 0x873D5D9F0DDE1FEF}, // 185
+    {0xEB57FF22FC0C7959, 0xA90CB506D155A7EB}, // 186
+    {0x9316FF75DD87CBD8, 0x09A7F12442D588F3}, // 187
+    {0xB7DCBF5354E9BECE, 0x0C11ED6D538AEB30}, // 188
+    {0xE5D3EF282A242E81, 0x8F1668C8A86DA5FB}, // 189
+    {0x8FA475791A569D10, 0xF96E017D694487BD}, // 190
+    {0xB38D92D760EC4455, 0x37C981DCC395A9AD}, // 191
+    {0xE070F78D3927556A, 0x85BBE253F47B1418}, // 192
+    {0x8C469AB843B89562, 0x93956D7478CCEC8F}, // 193
+    {0xAF58416654A6BABB, 0x387AC8D1970027B3}, // 194
+    {0xDB2E51BFE9D0696A, 0x06997B05FCC0319F}, // 195
+    {0x88FCF317F22241E2, 0x441FECE3BDF81F04}, // 196
+    {0xAB3C2FDDEEAAD25A, 0xD527E81CAD7626C4}, // 197
+    {0xD60B3BD56A5586F1, 0x8A71E223D8D3B075}, // 198
+    {0x85C7056562757456, 0xF6872D5667844E4A}, // 199
+    {0xA738C6BEBB12D16C, 0xB428F8AC016561DC}, // 200
+    {0xD106F86E69D785C7, 0xE13336D701BEBA53}, // 201
+    {0x82A45B450226B39C, 0xECC0024661173474}, // 202
+    {0xA34D721642B06084, 0x27F002D7F95D0191}, // 203
+    {0xCC20CE9BD35C78A5, 0x31EC038DF7B441F5}, // 204
+    {0xFF290242C83396CE, 0x7E67047175A15272}, // 205
+    {0x9F79A169BD203E41, 0x0F0062C6E984D387}, // 206
+    {0xC75809C42C684DD1, 0x52C07B78A3E60869}, // 207
+    {0xF92E0C3537826145, 0xA7709A56CCDF8A83}, // 208
+    {0x9BBCC7A142B17CCB, 0x88A66076400BB692}, // 209
+    {0xC2ABF989935DDBFE, 0x6ACFF893D00EA436}, // 210
+    {0xF356F7EBF83552FE, 0x0583F6B8C4124D44}, // 211
+    {0x98165AF37B2153DE, 0xC3727A337A8B704B}, // 212
+    {0xBE1BF1B059E9A8D6, 0x744F18C0592E4C5D}, // 213
+    {0xEDA2EE1C7064130C, 0x1162DEF06F79DF74}, // 214
+    {0x9485D4D1C63E8BE7, 0x8ADDCB5645AC2BA9}, // 215
+    {0xB9A74A0637CE2EE1, 0x6D953E2BD7173693}, // 216
+    {0xE8111C87C5C1BA99, 0xC8FA8DB6CCDD0438}, // 217
+    {0x910AB1D4DB9914A0, 0x1D9C9892400A22A3}, // 218
+    {0xB54D5E4A127F59C8, 0x2503BEB6D00CAB4C}, // 219
+    {0xE2A0B5DC971F303A, 0x2E44AE64840FD61E}, // 220
+    {0x8DA471A9DE737E24, 0x5CEAECFED289E5D3}, // 221
+    {0xB10D8E1456105DAD, 0x7425A83E872C5F48}, // 222
+    {0xDD50F1996B947518, 0xD12F124E28F7771A}, // 223
+    {0x8A5296FFE33CC92F, 0x82BD6B70D99AAA70}, // 224
+    {0xACE73CBFDC0BFB7B, 0x636CC64D1001550C}, // 225
+    {0xD8210BEFD30EFA5A, 0x3C47F7E05401AA4F}, // 226
+    {0x8714A775E3E95C78, 0x65ACFAEC34810A72}, // 227
+    {0xA8D9D1535CE3B396, 0x7F1839A741A14D0E}, // 228
+    {0xD31045A8341CA07C, 0x1EDE48111209A051}, // 229
+    {0x83EA2B892091E44D, 0x934AED0AAB460433}, // 230
+    {0xA4E4B66B68B65D60, 0xF81DA84D56178540}, // 231
+    {0xCE1DE40642E3F4B9, 0x36251260AB9D668F}, // 232
+    {0x80D2AE83E9CE78F3, 0xC1D72B7C6B42601A}, // 233
+    {0xA1075A24E4421730, 0xB24CF65B8612F820}, // 234
+    {0xC94930AE1D529CFC, 0xDEE033F26797B628}, // 235
+    {0xFB9B7CD9A4A7443C, 0x169840EF017DA3B2}, // 236
+    {0x9D412E0806E88AA5, 0x8E1F289560EE864F}, // 237
+    {0xC491798A08A2AD4E, 0xF1A6F2BAB92A27E3}, // 238
+    {0xF5B5D7EC8ACB58A2, 0xAE10AF696774B1DC}, // 239
+    {0x9991A6F3D6BF1765, 0xACCA6DA1E0A8EF2A}, // 240
+    {0xBFF610B0CC6EDD3F, 0x17FD090A58D32AF4}, // 241
+    {0xEFF394DCFF8A948E, 0xDDFC4B4CEF07F5B1}, // 242
+    {0x95F83D0A1FB69CD9, 0x4ABDAF101564F98F}, // 243
+    {0xBB764C4CA7A4440F, 0x9D6D1AD41ABE37F2}, // 244
+    {0xEA53DF5FD18D5513, 0x84C86189216DC5EE}, // 245
+    {0x92746B9BE2F8552C, 0x32FD3CF5B4E49BB5}, // 246
+    {0xB7118682DBB66A77, 0x3FBC8C33221DC2A2}, // 247
+    {0xE4D5E82392A40515, 0x0FABAF3FEAA5334B}, // 248
+    {0x8F05B1163BA6832D, 0x29CB4D87F2A7400F}, // 249
+    {0xB2C71D5BCA9023F8, 0x743E20E9EF511013}, // 250
+    {0xDF78E4B2BD342CF6, 0x914DA9246B255417}, // 251
+    {0x8BAB8EEFB6409C1A, 0x1AD089B6C2F7548F}, // 252
+    {0xAE9672ABA3D0C320, 0xA184AC2473B529B2}, // 253
+    {0xDA3C0F568CC4F3E8, 0xC9E5D72D90A2741F}, // 254
+    {0x8865899617FB1871, 0x7E2FA67C7A658893}, // 255
+    {0xAA7EEBFB9DF9DE8D, 0xDDBB901B98FEEAB8}, // 256
+    {0xD51EA6FA85785631, 0x552A74227F3EA566}, // 257
+    {0x8533285C936B35DE, 0xD53A88958F872760}, // 258
+    {0xA67FF273B8460356, 0x8A892ABAF368F138}, // 259
+    {0xD01FEF10A657842C, 0x2D2B7569B0432D86}, // 260
+    {0x8213F56A67F6B29B, 0x9C3B29620E29FC74}, // 261
+    {0xA298F2C501F45F42, 0x8349F3BA91B47B90}, // 262
+    {0xCB3F2F7642717713, 0x241C70A936219A74}, // 263
+    {0xFE0EFB53D30DD4D7, 0xED238CD383AA0111}, // 264
+    {0x9EC95D1463E8A506, 0xF4363804324A40AB}, // 265
+    {0xC67BB4597CE2CE48, 0xB143C6053EDCD0D6}, // 266
+    {0xF81AA16FDC1B81DA, 0xDD94B7868E94050B}, // 267
+    {0x9B10A4E5E9913128, 0xCA7CF2B4191C8327}, // 268
+    {0xC1D4CE1F63F57D72, 0xFD1C2F611F63A3F1}, // 269
+    {0xF24A01A73CF2DCCF, 0xBC633B39673C8CED}, // 270
+    {0x976E41088617CA01, 0xD5BE0503E085D814}, // 271
+    {0xBD49D14AA79DBC82, 0x4B2D8644D8A74E19}, // 272
+    {0xEC9C459D51852BA2, 0xDDF8E7D60ED1219F}, // 273
+    {0x93E1AB8252F33B45, 0xCABB90E5C942B504}, // 274
+    {0xB8DA1662E7B00A17, 0x3D6A751F3B936244}, // 275
+    {0xE7109BFBA19C0C9D, 0x0CC512670A783AD5}, // 276
+    {0x906A617D450187E2, 0x27FB2B80668B24C6}, // 277
+    {0xB484F9DC9641E9DA, 0xB1F9F660802DEDF7}, // 278
+    {0xE1A63853BBD26451, 0x5E7873F8A0396974}, // 279
+    {0x8D07E33455637EB2, 0xDB0B487B6423E1E9}, // 280
+    {0xB049DC016ABC5E5F, 0x91CE1A9A3D2CDA63}, // 281
+    {0xDC5C5301C56B75F7, 0x7641A140CC7810FC}, // 282
+    {0x89B9B3E11B6329BA, 0xA9E904C87FCB0A9E}, // 283
+    {0xAC2820D9623BF429, 0x546345FA9FBDCD45}, // 284
+    {0xD732290FBACAF133, 0xA97C177947AD4096}, // 285
+    {0x867F59A9D4BED6C0, 0x49ED8EABCCCC485E}, // 286
+    {0xA81F301449EE8C70, 0x5C68F256BFFF5A75}, // 287
+    {0xD226FC195C6A2F8C, 0x73832EEC6FFF3112}, // 288
+    {0x83585D8FD9C25DB7, 0xC831FD53C5FF7EAC}, // 289
+    {0xA42E74F3D032F525, 0xBA3E7CA8B77F5E56}, // 290
+    {0xCD3A1230C43FB26F, 0x28CE1BD2E55F35EC}, // 291
+    {0x80444B5E7AA7CF85, 0x7980D163CF5B81B4}, // 292
+    {0xA0555E361951C366, 0xD7E105BCC3326220}, // 293
+    {0xC86AB5C39FA63440, 0x8DD9472BF3FEFAA8}, // 294
+    {0xFA856334878FC150, 0xB14F98F6F0FEB952}, // 295
+    {0x9C935E00D4B9D8D2, 0x6ED1BF9A569F33D4}, // 296
+    {0xC3B8358109E84F07, 0x0A862F80EC4700C9}, // 297
+    {0xF4A642E14C6262C8, 0xCD27BB612758C0FB}, // 298
+    {0x98E7E9CCCFBD7DBD, 0x8038D51CB897789D}, // 299
+    {0xBF21E44003ACDD2C, 0xE0470A63E6BD56C4}, // 300
+    {0xEEEA5D5004981478, 0x1858CCFCE06CAC75}, // 301
+    {0x95527A5202DF0CCB, 0x0F37801E0C43EBC9}, // 302
+    {0xBAA718E68396CFFD, 0xD30560258F54E6BB}, // 303
+    {0xE950DF20247C83FD, 0x47C6B82EF32A206A}, // 304
+    {0x91D28B7416CDD27E, 0x4CDC331D57FA5442}, // 305
+    {0xB6472E511C81471D, 0xE0133FE4ADF8E953}, // 306
+    {0xE3D8F9E563A198E5, 0x58180FDDD97723A7}, // 307
+    {0x8E679C2F5E44FF8F, 0x570F09EAA7EA7649}, // 308
+    {0xB201833B35D63F73, 0x2CD2CC6551E513DB}, // 309
+    {0xDE81E40A034BCF4F, 0xF8077F7EA65E58D2}, // 310
+    {0x8B112E86420F6191, 0xFB04AFAF27FAF783}, // 311
+    {0xADD57A27D29339F6, 0x79C5DB9AF1F9B564}, // 312
+    {0xD94AD8B1C7380874, 0x18375281AE7822BD}, // 313
+    {0x87CEC76F1C830548, 0x8F2293910D0B15B6}, // 314
+    {0xA9C2794AE3A3C69A, 0xB2EB3875504DDB23}, // 315
+    {0xD433179D9C8CB841, 0x5FA60692A46151EC}, // 316
+    {0x849FEEC281D7F328, 0xDBC7C41BA6BCD334}, // 317
+    {0xA5C7EA73224DEFF3, 0x12B9B522906C0801}, // 318
+    {0xCF39E50FEAE16BEF, 0xD768226B34870A01}, // 319
+    {0x81842F29F2CCE375, 0xE6A1158300D46641}, // 320
+    {0xA1E53AF46F801C53, 0x60495AE3C1097FD1}, // 321
+    {0xCA5E89B18B602368, 0x385BB19CB14BDFC5}, // 322
+    {0xFCF62C1DEE382C42, 0x46729E03DD9ED7B6}, // 323
+    {0x9E19DB92B4E31BA9, 0x6C07A2C26A8346D2}, // 324
+};
+
+// Computes the 64 most significant bits of the 192 bits product g * cp (where g is a
+// 128 bits number), setting the least significant bit if any discarded bit is set
+LIBCJ_FN uint64_t round_to_odd(const uint64_t *const g, const uint64_t cp)
+{
+    uint64_t x_low, y_low;
+    const uint64_t x_high = multiply_high(g[1], cp, &x_low);
+    const uint64_t y_high = multiply_high(g[0], cp, &y_low);
+    const uint64_t middle = y_low + x_high;
+    const uint64_t high = y_high + ((middle < x_high) ? 1 : 0);
+    return high | ((middle > 1) ? 1 : 0);
+}
+
+// Finds the shortest decimal mantissa * 10^exponent that rounds to the given double
+// (closest to it in case of ties), using the Schubfach algorithm by Raffaello Giulietti
+// The value must be finite and nonzero, and the mantissa has no trailing zeros
+static uint64_t double_to_shortest(const struct Binary_Float *const value, int *const exponent)
+{
+    const uint64_t c = value->mantissa;
+    const int q = value->exponent;
+    const int fraction_bits = DBL_MANT_DIG - 1;
+    uint64_t mantissa;
+    int k;
+    if ((q <= 0) && (-q <= fraction_bits) && ((c & ((1ULL << -q) - 1)) == 0)) {
+        // Small integers are exactly representable
+        mantissa = c >> -q;
+        k = 0;
+    } else {
+        const bool accept_bounds = (c % 2) == 0;
+        // The lower neighbour is closer when the mantissa is a power of two, unless subnormal
+        const bool lower_boundary_is_closer = (c == (1ULL << fraction_bits)) && (q > (DBL_MIN_EXP - DBL_MANT_DIG));
+        const uint64_t cbl = 4 * c - 2 + (lower_boundary_is_closer ? 1 : 0);
+        const uint64_t cb = 4 * c;
+        const uint64_t cbr = 4 * c + 2;
+        // k = floor(log10(2^q)) or floor(log10(3/4 * 2^q)) and h = q + floor(log2(10^-k)) + 1
+        k = lower_boundary_is_closer ? floor_shift((int64_t)q * 1262611 - 524031, 22) : floor_shift((int64_t)q * 1262611, 22);
+        const int h = q + floor_shift((int64_t)(-k) * 1741647, 19) + 1;
+        const uint64_t *const g = shortest_powers_of_ten[-k - SHORTEST_MIN_POW10];
+        const uint64_t vbl = round_to_odd(g, cbl << h);
+        const uint64_t vb = round_to_odd(g, cb << h);
+        const uint64_t vbr = round_to_odd(g, cbr << h);
+        const uint64_t lower = vbl + (accept_bounds ? 0 : 1);
+        const uint64_t upper = vbr - (accept_bounds ? 0 : 1);
+        const uint64_t s = vb / 4;
+        bool done = false;
+        if (s >= 10) {
+            // Try one digit less
+            const uint64_t sp = s / 10;
+            const bool up_inside = lower <= 40 * sp;
+            const bool wp_inside = (40 * sp + 40) <= upper;
+            if (up_inside != wp_inside) {
+                mantissa = sp + (wp_inside ? 1 : 0);
+                k++;
+                done = true;
+            }
+        }
+        if (!done) {
+            const bool u_inside = lower <= 4 * s;
+            const bool w_inside = (4 * s + 4) <= upper;
+            if (u_inside != w_inside) {
+                mantissa = s + (w_inside ? 1 : 0);
+            } else {
+                const uint64_t middle = 4 * s + 2;
+                const bool round_up = (vb > middle) || ((vb == middle) && ((s & 1) != 0));
+                mantissa = s + (round_up ? 1 : 0);
+            }
+        }
+    }
+    while ((mantissa % 10) == 0) {
+        mantissa /= 10;
+        k++;
+    }
+    *exponent = k;
+    return mantissa;
+}
+
+// Computes a = a - b * factor, where the result must not be negative
+LIBCJ_FN void big_int_sub_mul(struct Big_Int *const a, const struct Big_Int *const b, const uint32_t factor)
+{
+    uint64_t carry = 0;
+    uint64_t borrow = 0;
+    for (int i = 0; i < a->size; i++) {
+        const uint64_t product = ((i < b->size) ? ((uint64_t)b->limbs[i] * factor) : 0) + carry;
+        const uint64_t subtrahend = (uint32_t)product + borrow;
+        carry = product >> 32;
+        borrow = ((uint64_t)a->limbs[i] < subtrahend) ? 1 : 0;
+        a->limbs[i] = (uint32_t)((uint64_t)a->limbs[i] - subtrahend);
+    }
+    while ((a->size > 0) && (a->limbs[a->size-1] == 0)) {
+        a->size--;
+    }
+}
+
+// Prepares the generation of the decimal digits of the nonzero value r * 2^exponent, where r
+// (already set in the generator) has the given amount of bits
+static void digit_generator_start(struct Digit_Generator *const generator, const int exponent, const int bits)
+{
+    struct Big_Int *const r = &generator->r;
+    struct Big_Int *const s = &generator->s;
+    // The value is r/s
+    big_int_set(s, 1);
+    if (exponent >= 0) {
+        big_int_shift_left(r, exponent);
+    } else {
+        big_int_shift_left(s, -exponent);
+    }
+    // Estimate the exponent k of the first digit, and scale r/s to value/10^(k+1)
+    int k = floor_log10_pow2(exponent + bits - 1);
+    if (k >= -1) {
+        big_int_mul_pow10(s, k + 1);
+    } else {
+        big_int_mul_pow10(r, -(k + 1));
+    }
+    // Fix the estimate, so that 0.1 <= r/s < 1
+    while (big_int_compare(r, s) >= 0) {
+        big_int_mul_add(s, 10, 0);
+        k++;
+    }
+    for (;;) {
+        struct Big_Int scaled;
+        big_int_copy(&scaled, r);
+        big_int_mul_add(&scaled, 10, 0);
+        if (big_int_compare(&scaled, s) >= 0) {
+            break;
+        }
+        big_int_copy(r, &scaled);
+        k--;
+    }
+    // Normalize s, so that its most significant limb can be used to estimate quotients
+    const int shift = 32 * s->size - big_int_bit_length(s);
+    big_int_shift_left(r, shift);
+    big_int_shift_left(s, shift);
+    generator->exponent = k;
+    generator->chunk_index = (int)sizeof(generator->chunk);
+}
+
+// Prepares the generation of the decimal digits of a finite nonzero value
+static void digit_generator_init(struct Digit_Generator *const generator, const struct Binary_Float *const value)
+{
+    big_int_set(&generator->r, value->mantissa);
+    digit_generator_start(generator, value->exponent, bit_length(value->mantissa));
+}
+
+// Returns the next decimal digit of the value
+LIBCJ_FN char digit_generator_next(struct Digit_Generator *const generator)
+{
+    struct Big_Int *const r = &generator->r;
+    const struct Big_Int *const s = &generator->s;
+    if (generator->chunk_index < (int)sizeof(generator->chunk)) {
+        return generator->chunk[generator->chunk_index++];
+    }
+    if (r->size == 0) { // All the remaining digits are zeros
+        return '0';
+    }
+    // The quotient of (r * 10^9) / s has the next 9 digits. It is estimated from the most
+    // significant limbs, and the estimate is at most two units smaller than the quotient
+    big_int_mul_add(r, small_powers_of_ten[9], 0);
+    const int top = s->size - 1;
+    const uint64_t r_high = (r->size > (top + 1)) ? ((uint64_t)r->limbs[top+1] << 32) : 0;
+    const uint64_t r_low = (r->size > top) ? r->limbs[top] : 0;
+    uint64_t quotient = (r_high | r_low) / ((uint64_t)s->limbs[top] + 1);
+    big_int_sub_mul(r, s, (uint32_t)quotient);
+    while (big_int_compare(r, s) >= 0) {
+        big_int_sub(r, s);
+        quotient++;
+    }
+    write_decimal(generator->chunk, quotient, (int)sizeof(generator->chunk));
+    generator->chunk_index = 1;
+    return generator->chunk[0];
+}
+
+// Checks if all the remaining digits are zeros
+LIBCJ_FN bool digit_generator_exhausted(const struct Digit_Generator *const generator)
+{
+    if (generator->r.size != 0) {
+        return false;
+    }
+    for (int i = generator->chunk_index; i < (int)sizeof(generator->chunk); i++) {
+        if (generator->chunk[i] != '0') {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Compares the decimal with the halfway point (mantissa + 1/2) * 2^exponent, whose exact digits
+// are generated until they differ. Returns a negative number, zero or a positive number if the
+// decimal is less, equal or greater. The mantissa of a decimal with discarded digits has 19 digits
+static NOINLINE_FUNCTION int decimal_compare_halfway(const struct Decimal *const dec, const uint64_t mantissa, const int exponent)
+{
+    struct Digit_Generator generator;
+    char leading[19];
+    big_int_set(&generator.r, mantissa);
+    big_int_shift_left(&generator.r, 1);
+    big_int_mul_add(&generator.r, 1, 1);
+    digit_generator_start(&generator, exponent - 1, bit_length(mantissa) + 1);
+    if (generator.exponent != (dec->exponent + 18)) {
+        return (generator.exponent < (dec->exponent + 18)) ? 1 : -1;
+    }
+    write_decimal(leading, dec->mantissa, 19);
+    const char *cursor = dec->first_discarded;
+    for (int i = 0; i < (19 + dec->discarded_digits); i++) {
+        if ((i >= 19) && (*cursor == '.')) {
+            cursor++;
+        }
+        const char digit = (i < 19) ? leading[i] : *cursor++;
+        const char halfway = digit_generator_next(&generator);
+        if (digit != halfway) {
+            return (digit > halfway) ? 1 : -1;
+        }
+    }
+    return digit_generator_exhausted(&generator) ? 0 : -1;
+}
+
+// Checks if the remaining digits are more than half of the last generated one,
+// or exactly half of it when the last digit is odd (ties to even)
+LIBCJ_FN bool digit_generator_round_up(struct Digit_Generator *const generator, const bool odd)
+{
+    if (generator->chunk_index < (int)sizeof(generator->chunk)) {
+        const char digit = generator->chunk[generator->chunk_index++];
+        if (digit != '5') {
+            return digit > '5';
+        }
+        return !digit_generator_exhausted(generator) || odd;
+    }
+    struct Big_Int twice;
+    big_int_copy(&twice, &generator->r);
+    big_int_shift_left(&twice, 1);
+    const int cmp = big_int_compare(&twice, &generator->s);
+    return (cmp > 0) || ((cmp == 0) && odd);
+}
+
+// Computes the decimal digits of a finite binary floating point number, correctly
+// rounded (ties to even) at the requested position, using big integers (Dragon4)
+// For Fmt_e, 'precision' is the amount of digits after the first one, otherwise it
+// is the amount of digits after the decimal point
+// Only the first digits are stored, so any precision is handled in linear time
+// With exponent_only, the generation stops at the first digit that isn't a nine, because the
+// rounding can't carry into a new leading digit anymore, and only the exponent is valid
+static void float_to_digits(const struct Binary_Float *const value, const enum Fmt_Specifier specifier, const int precision,
+    const bool exponent_only, struct Float_Digits *const digits)
+{
+    digits->value = *value;
+    digits->count = 0;
+    digits->exponent = 0;
+    digits->round_up = false;
+    digits->carried = false;
+    digits->last_non_nine = -1;
+    digits->last_nonzero = -1;
+    digits->next = 0;
+    if (value->mantissa == 0) {
+        return;
+    }
+    digit_generator_init(&digits->generator, value);
+    const int k = digits->generator.exponent;
+    const int64_t last = (specifier == Fmt_e) ? ((int64_t)k - precision) : -(int64_t)precision;
+    const int64_t count = (int64_t)k - last + 1;
+    if (count < 0) { // The value is less than a tenth of the last digit, so it rounds to zero
+        return;
+    }
+    digits->count = (int)MIN(count, INT_MAX);
+    digits->exponent = k;
+    char digit = '0';
+    int index = 0;
+    for (; index < digits->count; index++) {
+        // The expansion of binary numbers is finite, the next digits are zeros
+        if (digit_generator_exhausted(&digits->generator)) {
+            digits->count = index;
+            return;
+        }
+        digit = digit_generator_next(&digits->generator);
+        if (index < FLOAT_DIGITS_CACHE_SIZE) {
+            digits->cache[index] = digit;
+        }
+        if (digit != '9') {
+            digits->last_non_nine = index;
+            if (exponent_only) {
+                digits->count = index + 1;
+                return;
+            }
+        }
+        if (digit != '0') {
+            digits->last_nonzero = index;
+        }
+    }
+    const bool odd = (index > 0) && (((digit - '0') & 1) != 0);
+    digits->round_up = digit_generator_round_up(&digits->generator, odd);
+    if (digits->round_up) {
+        if (digits->last_non_nine < 0) { // All digits were nines, so the carry creates a new leading digit
+            digits->carried = true;
+            digits->exponent++;
+            if (specifier != Fmt_e) {
+                digits->count++;
+            }
+            digits->last_nonzero = 0;
+        } else {
+            digits->last_nonzero = digits->last_non_nine;
+        }
+    }
+}
+
+// Returns the next decimal digit, the first one has weight 10^exponent
+LIBCJ_FN char float_digit_next(struct Float_Digits *const digits)
+{
+    const int index = digits->next++;
+    if (digits->carried) {
+        return (index == 0) ? '1' : '0';
+    }
+    if ((index >= digits->count) || (digits->round_up && (index > digits->last_non_nine))) {
+        return '0';
+    }
+    char digit;
+    if (index < FLOAT_DIGITS_CACHE_SIZE) {
+        digit = digits->cache[index];
+    } else {
+        if (index == FLOAT_DIGITS_CACHE_SIZE) { // Generate the digits again, skipping the stored ones
+            digit_generator_init(&digits->generator, &digits->value);
+            for (int i = 0; i < FLOAT_DIGITS_CACHE_SIZE; i++) {
+                digit_generator_next(&digits->generator);
+            }
+        }
+        digit = digit_generator_next(&digits->generator);
+    }
+    return (digits->round_up && (index == digits->last_non_nine)) ? (char)(digit + 1) : digit;
+}
+
+// Amount of digits from the next one up to the last that may be nonzero, the ones after it are zeros
+LIBCJ_FN int float_digits_left(const struct Float_Digits *const digits)
+{
+    if (digits->carried) {
+        return (digits->next == 0) ? 1 : 0;
+    }
+    const int end = digits->round_up ? MIN(digits->count, digits->last_non_nine + 1) : digits->count;
+    return MAX(end - digits->next, 0);
+}
+
+// Stores the shortest digits of a double, when they are also the digits that %g prints with the
+// given precision, and returns true. When the shortest representation has at most DBL_DIG
+// digits, it is also correctly rounded to any precision up to DBL_DIG, because normal doubles
+// are much closer to each other than decimals with this amount of digits
+LIBCJ_FN bool float_to_shortest_digits(const struct Binary_Float *const value, const struct Float_Format *const format, const int precision, struct Float_Digits *const digits)
+{
+    if ((format != &double_format) || (precision > DBL_DIG) || (value->mantissa < (1ULL << (DBL_MANT_DIG - 1)))) {
+        return false;
+    }
+    int exponent;
+    const uint64_t mantissa = double_to_shortest(value, &exponent);
+    const int length = decimal_length(mantissa);
+    if (length > precision) {
+        return false;
+    }
+    write_decimal(digits->cache, mantissa, length);
+    digits->value = *value;
+    digits->count = length;
+    digits->exponent = exponent + length - 1;
+    digits->round_up = false;
+    digits->carried = false;
+    digits->last_non_nine = -1;
+    digits->last_nonzero = length - 1;
+    digits->next = 0;
+    return true;
+}
+
+// Largest integer part and precision handled by float_to_fixed_digits
+#define FIXED_DIGITS_MAX_INTEGER   1000000000000000ULL // 10^15
+#define FIXED_DIGITS_MAX_PRECISION 9
+
+// Stores the digits of a double printed by %f with small precision, using only integer
+// arithmetic, and returns true. The value is split into its integer part and its fraction
+// f / 2^q, which is multiplied by 10^precision with 128 bits and rounded once (ties to even)
+LIBCJ_FN bool float_to_fixed_digits(const struct Binary_Float *const value, const struct Float_Format *const format, const int precision, struct Float_Digits *const digits)
+{
+    const int q = -value->exponent;
+    if ((format != &double_format) || (precision > FIXED_DIGITS_MAX_PRECISION) || (q >= 128) || (q <= -64)) {
+        return false;
+    }
+    uint64_t integer = 0;
+    uint64_t fraction = 0;
+    if (q <= 0) {
+        if ((value->mantissa > (FIXED_DIGITS_MAX_INTEGER >> -q))) {
+            return false;
+        }
+        integer = value->mantissa << -q;
+    } else {
+        const uint64_t scale = uint64_powers_of_ten[precision];
+        uint64_t low;
+        const uint64_t high = multiply_high((q < 64) ? (value->mantissa & ((1ULL << q) - 1)) : value->mantissa, scale, &low);
+        uint64_t remainder_high, half_high;
+        uint64_t remainder_low, half_low;
+        integer = (q < 64) ? (value->mantissa >> q) : 0;
+        if (integer >= FIXED_DIGITS_MAX_INTEGER) {
+            return false;
+        }
+        // Split the product in the quotient by 2^q and the remainder, to be compared with 2^(q-1)
+        if (q < 64) {
+            fraction = (high << (64 - q)) | (low >> q);
+            remainder_high = 0;
+            remainder_low = low & ((1ULL << q) - 1);
+            half_high = 0;
+            half_low = 1ULL << (q - 1);
+        } else if (q == 64) {
+            fraction = high;
+            remainder_high = 0;
+            remainder_low = low;
+            half_high = 0;
+            half_low = 1ULL << 63;
+        } else {
+            fraction = high >> (q - 64);
+            remainder_high = high & ((1ULL << (q - 64)) - 1);
+            remainder_low = low;
+            half_high = 1ULL << (q - 65);
+            half_low = 0;
+        }
+        const bool above_half = (remainder_high > half_high) || ((remainder_high == half_high) && (remainder_low > half_low));
+        const bool tie = (remainder_high == half_high) && (remainder_low == half_low);
+        // Without fractional digits, the last printed digit belongs to the integer part
+        const uint64_t last = (precision == 0) ? integer : fraction;
+        if (above_half || (tie && ((last & 1) != 0))) {
+            fraction++;
+            if (fraction == scale) {
+                fraction = 0;
+                integer++;
+            }
+        }
+    }
+    digits->value = *value;
+    digits->round_up = false;
+    digits->carried = false;
+    digits->last_non_nine = -1;
+    digits->next = 0;
+    if (integer != 0) {
+        const int length = decimal_length(integer);
+        write_decimal(digits->cache, integer, length);
+        write_decimal(&digits->cache[length], fraction, precision);
+        digits->count = length + precision;
+        digits->exponent = length - 1;
+    } else if (fraction != 0) {
+        const int length = decimal_length(fraction);
+        write_decimal(digits->cache, fraction, length);
+        digits->count = length;
+        digits->exponent = length - precision - 1;
+    } else {
+        digits->count = 0;
+        digits->exponent = 0;
+    }
+    digits->last_nonzero = digits->count - 1;
+    return true;
+}
+
+// Generic function to convert floating point numbers to string in decimal form (%f, %e or %g)
+// Return the amount of characters that would have been written if we had enough size
+static int float_to_str(struct Sink *const sink,
+    const int width, int precision, const enum Fmt_Flags flags, const enum Fmt_Specifier specifier,
+    const struct Binary_Float *const value, const struct Float_Format *const format)
+{
+    struct Float_Digits digits;
+    const bool uppercase = (flags & Flag_Upper) != 0;
+    const bool left_justify = (flags & Flag_Minus) != 0;
+    const bool alternative_form = (flags & Flag_Hash) != 0;
+    const bool finite = value->kind == Float_Finite;
+    const bool discard = sink_discards(sink);
+    // Flag_Zero is ignored if Flag_Minus is informed
+    const bool pad_with_zeros = finite && !left_justify && ((flags & Flag_Zero) != 0);
+    const char sign = value->negative ? '-' : ((flags & Flag_Plus) ? '+' : ((flags & Flag_Space) ? ' ' : '\0'));
+    bool exponent_form = specifier == Fmt_e;
+    int exponent = 0;
+    int exponent_length = 0;
+    int body_length = 3; // Length of inf and nan
+    if (precision < 0) { // Default precision
+        precision = 6;
+    }
+    if (finite) {
+        if (specifier == Fmt_g) {
+            // The precision is the amount of significant digits, and the style depends on the exponent
+            precision = MAX(precision, 1);
+            if (!float_to_shortest_digits(value, format, precision, &digits)) {
+                float_to_digits(value, Fmt_e, precision - 1, false, &digits);
+            }
+            exponent_form = (digits.exponent < -4) || (digits.exponent >= precision);
+            precision = exponent_form ? (precision - 1) : (precision - 1 - digits.exponent);
+            if (!alternative_form) { // Remove the trailing zeros
+                const int point = exponent_form ? digits.exponent : 0;
+                const int last_nonzero = digits.exponent - digits.last_nonzero;
+                precision = (digits.last_nonzero < 0) ? 0 : MIN(precision, MAX(point - last_nonzero, 0));
+            }
+        } else if ((specifier != Fmt_f) || !float_to_fixed_digits(value, format, precision, &digits)) {
+            float_to_digits(value, specifier, precision, discard, &digits);
+        }
+        if (exponent_form) {
+            exponent = digits.exponent;
+            for (int x = ABS(exponent); (x > 0) || (exponent_length < 2); x /= 10) {
+                exponent_length++;
+            }
+            body_length = 1 + 2 + exponent_length;
+        } else {
+            body_length = MAX(digits.exponent, 0) + 1;
+        }
+        if ((precision > 0) || alternative_form) {
+            body_length += 1 + precision;
+        }
+    }
+    const int padding = width - body_length - ((sign != '\0') ? 1 : 0);
+    if (discard) {
+        return ((sign != '\0') ? 1 : 0) + MAX(padding, 0) + body_length;
+    }
+    if (!left_justify && !pad_with_zeros) {
+        sink_fill(sink, ' ', padding);
+    }
+    if (sign != '\0') {
+        sink_putc(sink, sign);
+    }
+    if (pad_with_zeros) {
+        sink_fill(sink, '0', padding);
+    }
+    if (!finite) {
+        const char *name = (value->kind == Float_Infinite) ? (uppercase ? "INF" : "inf") : (uppercase ? "NAN" : "nan");
+        sink_append(sink, name, 3);
+    } else {
+        // Position of the first digit and of the decimal point
+        const int first = exponent_form ? digits.exponent : MAX(digits.exponent, 0);
+        const int point = exponent_form ? digits.exponent : 0;
+        for (int position = first; position >= point; position--) {
+            sink_putc(sink, (position > digits.exponent) ? '0' : float_digit_next(&digits));
+        }
+        if ((precision > 0) || alternative_form) {
+            sink_putc(sink, '.');
+        }
+        // The leading and trailing zeros of the fraction are written at once
+        const int leading = MIN(MAX(point - 1 - digits.exponent, 0), precision);
+        const int significant = MIN(precision - leading, float_digits_left(&digits));
+        sink_fill(sink, '0', leading);
+        for (int i = 0; i < significant; i++) {
+            sink_putc(sink, float_digit_next(&digits));
+        }
+        sink_fill(sink, '0', precision - leading - significant);
+        if (exponent_form) {
+            sink_putc(sink, uppercase ? 'E' : 'e');
+            sink_putc(sink, (exponent < 0) ? '-' : '+');
+            int divisor = 1;
+            for (int i = 1; i < exponent_length; i++) {
+                divisor *= 10;
+            }
+            for (; divisor > 0; divisor /= 10) {
+                sink_putc(sink, (char)('0' + (ABS(exponent) / divisor) % 10));
+            }
+        }
+    }
+    if (left_justify) {
+        sink_fill(sink, ' ', padding);
+    }
+    const int written = ((sign != '\0') ? 1 : 0) + MAX(padding, 0) + body_length;
+    // This function doesn't need to introduce null termination to the buffer
+    // This is responsability of its caller
+    return written;
+}
+
+// Converts floating point numbers to string in hexadecimal form (%a), straight from the mantissa
+// bits. The fraction is printed in whole nibbles after the leading digit (one bit for double,
+// the top nibble for x87 long double), and rounded to nearest (ties to even) at reduced precision
+// Return the amount of characters that would have been written if we had enough size
+static int float_to_hex_str(struct Sink *const sink,
+    const int width, int precision, const enum Fmt_Flags flags,
+    const struct Binary_Float *const value, const struct Float_Format *const format)
+{
+    const bool uppercase = (flags & Flag_Upper) != 0;
+    const bool left_justify = (flags & Flag_Minus) != 0;
+    const bool alternative_form = (flags & Flag_Hash) != 0;
+    const bool finite = value->kind == Float_Finite;
+    // Flag_Zero is ignored if Flag_Minus is informed
+    const bool pad_with_zeros = finite && !left_justify && ((flags & Flag_Zero) != 0);
+    const char sign = value->negative ? '-' : ((flags & Flag_Plus) ? '+' : ((flags & Flag_Space) ? ' ' : '\0'));
+    int fraction_bits = 4 * ((format->mantissa_bits - 1) / 4);
+    uint64_t mantissa = value->mantissa;
+    int exponent = (mantissa != 0) ? (value->exponent + fraction_bits) : 0;
+    int nibbles = fraction_bits / 4;
+    int body_length = 3; // Length of inf and nan
+    if (finite) {
+        if (precision < 0) { // Exact representation, without trailing zeros
+            while ((nibbles > 0) && (((mantissa >> (fraction_bits - 4 * nibbles)) & 0xF) == 0)) {
+                nibbles--;
+            }
+            precision = nibbles;
+        } else if (precision < nibbles) {
+            const int shift = fraction_bits - 4 * precision;
+            const uint64_t remainder = mantissa & ((1ULL << shift) - 1);
+            const uint64_t half = 1ULL << (shift - 1);
+            mantissa >>= shift;
+            if ((remainder > half) || ((remainder == half) && ((mantissa & 1) != 0))) {
+                mantissa++;
+            }
+            fraction_bits -= shift;
+            nibbles = precision;
+            if ((mantissa >> fraction_bits) > 0xF) { // The leading nibble carried
+                mantissa >>= 4;
+                exponent += 4;
+            }
+        }
+        body_length = 2 + 1 + 2 + decimal_length((uint64_t)ABS(exponent));
+        if ((precision > 0) || alternative_form) {
+            body_length += 1 + precision;
+        }
+    }
+    const int padding = width - body_length - ((sign != '\0') ? 1 : 0);
+    if (sink_discards(sink)) {
+        return ((sign != '\0') ? 1 : 0) + MAX(padding, 0) + body_length;
+    }
+    if (!left_justify && !pad_with_zeros) {
+        sink_fill(sink, ' ', padding);
+    }
+    if (sign != '\0') {
+        sink_putc(sink, sign);
+    }
+    if (!finite) {
+        const char *name = (value->kind == Float_Infinite) ? (uppercase ? "INF" : "inf") : (uppercase ? "NAN" : "nan");
+        sink_append(sink, name, 3);
+    } else {
+        char digits[24];
+        sink_append(sink, uppercase ? "0X" : "0x", 2);
+        if (pad_with_zeros) {
+            sink_fill(sink, '0', padding);
+        }
+        sink_putc(sink, (char)VALUE_TO_CHAR(mantissa >> fraction_bits, uppercase));
+        if ((precision > 0) || alternative_form) {
+            sink_putc(sink, '.');
+        }
+        for (int i = 1; i <= precision; i++) {
+            const uint64_t nibble = (i <= nibbles) ? ((mantissa >> (fraction_bits - 4 * i)) & 0xF) : 0;
+            sink_putc(sink, (char)VALUE_TO_CHAR(nibble, uppercase));
+        }
+        sink_putc(sink, uppercase ? 'P' : 'p');
+        sink_putc(sink, (exponent < 0) ? '-' : '+');
+        const int length = decimal_length((uint64_t)ABS(exponent));
+        write_decimal(digits, (uint64_t)ABS(exponent), length);
+        sink_append(sink, digits, (size_t)length);
+    }
+    if (left_justify) {
+        sink_fill(sink, ' ', padding);
+    }
+    const int written = ((sign != '\0') ? 1 : 0) + MAX(padding, 0) + body_length;
+    // This function doesn't need to introduce null termination to the buffer
+    // This is responsability of its caller
+    return written;
+}
+
+// Returns the length of the string, up to precision characters if it isn't negative
+LIBCJ_FN size_t string_length(const char *const string, const int precision)
+{
+    if (precision >= 0) { // With a precision, the string doesn't need to be null terminated
+        const char *const end = memchr(string, '\0', (size_t)precision);
+        return (end != NULL) ? (size_t)(end - string) : (size_t)precision;
+    }
+    return strlen(string);
+}
+
+static int put_string(struct Sink *const sink, const int width, const int precision, const bool left_justify, const char *string)
+{
+    if (string == NULL) {
+        string = "(null)";
+    }
+    const size_t len = string_length(string, precision);
+    const int padding = width - (int)len;
+    if (sink_discards(sink)) {
+        return (int)len + MAX(padding, 0);
+    }
+    if (!left_justify) {
+        sink_fill(sink, ' ', padding);
+    }
+    sink_append(sink, string, len);
+    if (left_justify) {
+        sink_fill(sink, ' ', padding);
+    }
+    return (int)len + MAX(padding, 0);
+}
+
+// Checks if the character must be escaped in a JSON or C string literal: control characters,
+// double quotes and backslashes, and also DEL in C. Other bytes (as UTF-8 sequences) are kept
+LIBCJ_FN bool char_needs_escape(const char c, const enum Escape_Style style)
+{
+    return ((unsigned char)c < 0x20) || (c == '"') || (c == '\\') || ((style == Escape_c) && (c == 0x7F));
+}
+
+// Returns a mask with the most significant bit of each byte of the word set if that byte must be escaped
+LIBCJ_FN uint64_t word_needs_escape(const uint64_t word, const enum Escape_Style style)
+{
+    const uint64_t found = word_control_bytes(word) | word_bytes_equal(word, '"') | word_bytes_equal(word, '\\');
+    return (style == Escape_c) ? (found | word_bytes_equal(word, 0x7F)) : found;
+}
+
+// Returns the index of the first character from str[index] to str[len-1] that must be escaped,
+// or len if there is none. The characters are checked 8 at a time while possible
+LIBCJ_FN size_t find_escape(const char *const str, size_t index, const size_t len, const enum Escape_Style style)
+{
+    for (; (len - index) >= 8; index += 8) {
+        const uint64_t found = word_needs_escape(load_word(&str[index]), style);
+        if (found != 0) {
+            return index + (size_t)(count_trailing_zeros(found) / 8);
+        }
+    }
+    while ((index < len) && !char_needs_escape(str[index], style)) {
+        index++;
+    }
+    return index;
+}
+
+// Writes the escape sequence of the character c to sequence, returning its length
+// JSON uses \u00XX for the characters without a short sequence, and C uses 3 octal digits,
+// that unlike \x can't take in the hexadecimal digits that follow
+LIBCJ_FN size_t escape_sequence(char *const sequence, const unsigned char c, const enum Escape_Style style)
+{
+    sequence[0] = '\\';
+    switch (c) {
+    case '"':  sequence[1] = '"';  return 2;
+    case '\\': sequence[1] = '\\'; return 2;
+    case '\b': sequence[1] = 'b';  return 2;
+    case '\f': sequence[1] = 'f';  return 2;
+    case '\n': sequence[1] = 'n';  return 2;
+    case '\r': sequence[1] = 'r';  return 2;
+    case '\t': sequence[1] = 't';  return 2;
+    default: break;
+    }
+    if (style == Escape_json) {
+        memcpy(&sequence[1], "u00", 3);
+        sequence[4] = (char)VALUE_TO_CHAR(c >> 4, false);
+        sequence[5] = (char)VALUE_TO_CHAR(c & 0x0F, false);
+        return 6;
+    }
+    if ((c == '\a') || (c == '\v')) {
+        sequence[1] = (c == '\a') ? 'a' : 'v';
+        return 2;
+    }
+    sequence[1] = (char)('0' + (c >> 6));
+    sequence[2] = (char)('0' + ((c >> 3) & 7));
+    sequence[3] = (char)('0' + (c & 7));
+    return 4;
+}
+
+// Writes len characters of str escaped for a JSON or C string literal, without the quotes
+// The runs of characters that don't need escaping are appended with a single copy
+// Returns the length of the escaped string
+static size_t escape_to_sink(struct Sink *const sink, const char *const str, const size_t len, const enum Escape_Style style)
+{
+    size_t written = 0;
+    for (size_t index = 0; index < len; ) {
+        const size_t end = find_escape(str, index, len, style);
+        sink_append(sink, &str[index], end - index);
+        written += end - index;
+        if (end == len) {
+            break;
+        }
+        char sequence[6];
+        const size_t sequence_len = escape_sequence(sequence, (unsigned char)str[end], style);
+        sink_append(sink, sequence, sequence_len);
+        written += sequence_len;
+        index = end + 1;
+    }
+    return written;
+}
+
+// Writes the string escaped for a JSON or C string literal, between double quotes with the '#' flag
+// Width and precision work like in put_string, the precision limits the characters read from the string
+static int put_escaped(struct Sink *const sink, const int width, const int precision, const bool left_justify, const bool quoted, const char *string, const enum Escape_Style style)
+{
+    if (string == NULL) {
+        return put_string(sink, width, -1, left_justify, "(null)");
+    }
+    const size_t len = string_length(string, precision);
+    const int quotes = quoted ? 2 : 0;
+    int padding = 0;
+    // Escaping never shortens the string, so its length is only computed when it may need padding
+    if ((width - quotes) > (int)len) {
+        struct Sink counter;
+        sink_counter(&counter);
+        padding = width - quotes - (int)escape_to_sink(&counter, string, len, style);
+    }
+    if (!left_justify) {
+        sink_fill(sink, ' ', padding);
+    }
+    if (quoted) {
+        sink_putc(sink, '"');
+    }
+    const size_t escaped_len = escape_to_sink(sink, string, len, style);
+    if (quoted) {
+        sink_putc(sink, '"');
+    }
+    if (left_justify) {
+        sink_fill(sink, ' ', padding);
+    }
+    return (int)escaped_len + quotes + MAX(padding, 0);
+}
+
+LIBCJ_FN int parse_fmt_flags(const char *const fmt, enum Fmt_Flags *const flags)
+{
+    *flags = Flag_None;
+    int index = 0;
+    for (; fmt[index] != '\0'; index++) {
+        switch (fmt[index]) {
+        case '-': *flags |= Flag_Minus; break;
+        case '+': *flags |= Flag_Plus;  break;
+        case ' ': *flags |= Flag_Space; break;
+        case '#': *flags |= Flag_Hash;  break;
+        case '0': *flags |= Flag_Zero;  break;
+        default: return index;
+        }
+    }
+    return index;
+}
+
+LIBCJ_FN int parse_width_precision(const char *const fmt, int *const width, int *const precision)
+{
+    int index = 0;
+    if (fmt[index] == '*') {
+        index++;
+        *width = FMT_FROM_ARGUMENT;
+    } else {
+        index += str_to_natural(&fmt[index], width);
+    }
+    if (fmt[index] == '.') {
+        index++;
+        if (fmt[index] == '*') {
+            index++;
+            *precision = FMT_FROM_ARGUMENT;
+        } else {
+            index += str_to_natural(&fmt[index], precision);
+        }
+    }
+    return index;
+}
+
+LIBCJ_FN int parse_fmt_specifier(const char *const fmt, enum Fmt_Specifier *const specifier, enum Length_Modifier *const modifier, bool *const uppercase)
+{
+    int index = 0;
+    *specifier = Fmt_unknown;
+    // Parse the length modifier
+    *modifier = Modifier_None;
+    if (fmt[index] == 'h') {
+        index++;
+        if (fmt[index] == 'h') {
+            index++;
+            *modifier = Modifier_char;
+        } else {
+            *modifier = Modifier_short;
+        }
+    } else if (fmt[index] == 'l') {
+        index++;
+        if (fmt[index] == 'l') {
+            index++;
+            *modifier = Modifier_llong;
+        } else {
+            *modifier = Modifier_long;
+        }
+    } else if (fmt[index] == 'L') {
+        index++;
+        *modifier = Modifier_ldouble;
+    }
+    // Parse the format specifier
+    switch (fmt[index]) {
+    // Integers
+    case 'd': *specifier = Fmt_d; break;
+    case 'i': *specifier = Fmt_i; break;
+    case 'u': *specifier = Fmt_u; break;
+    case 'o': *specifier = Fmt_o; break;
+    case 'x':
+    case 'X': *specifier = Fmt_x; break;
+    // Floating points
+    case 'f':
+    case 'F': *specifier = Fmt_f; break;
+    case 'e':
+    case 'E': *specifier = Fmt_e; break;
+    case 'g':
+    case 'G': *specifier = Fmt_g; break;
+    case 'a':
+    case 'A': *specifier = Fmt_a; break;
+    // Others
+    case 'c': *specifier = Fmt_c; break;
+    case 's': *specifier = Fmt_s; break;
+    case 'p': *specifier = Fmt_p; break;
+    case 'n': *specifier = Fmt_n; break;
+    case '%': *specifier = Fmt_percent; break;
+    // Extensions
+    case 'J': *specifier = Fmt_json; break;
+    case 'Q': *specifier = Fmt_cstr; break;
+    }
+    if (*specifier == Fmt_unknown) {
+        return 0;
+    }
+    if (uppercase != NULL) {
+        *uppercase = isupper(fmt[index]);
+    }
+    // Return the amount of characters parsed
+    return (index + 1);
+}
+
+// Handlers of the custom conversions, indexed by their letter
+struct Fmt_Handler {
+    cj_fmt_handler handler;
+    void *ctx;
+};
+
+static struct Fmt_Handler fmt_handlers[128];
+// Incremented when the handlers change, so that the formats compiled before are compiled again
+static unsigned fmt_handlers_generation;
+
+LIBCJ_FN const struct Fmt_Handler *find_fmt_handler(const char letter)
+{
+    const unsigned char index = (unsigned char)letter;
+    return ((index < 128) && (fmt_handlers[index].handler != NULL)) ? &fmt_handlers[index] : NULL;
+}
+
+// Parses a conversion specification, after the initial '%'
+// snprintf format specifier follows this pattern:
+// %[flags][width][.precision][length]specifier
+// https://cplusplus.com/reference/cstdio/printf/
+// Returns the amount of characters parsed, or zero if the specifier is unknown
+LIBCJ_FN int parse_fmt_spec(const char *const fmt, struct Fmt_Spec *const spec)
+{
+    bool uppercase;
+    int parsed_chars = 0;
+    spec->width = -1;
+    spec->precision = -1;
+    parsed_chars += parse_fmt_flags(&fmt[parsed_chars], &spec->flags);
+    parsed_chars += parse_width_precision(&fmt[parsed_chars], &spec->width, &spec->precision);
+    const int specifier_chars = parse_fmt_specifier(&fmt[parsed_chars], &spec->specifier, &spec->modifier, &uppercase);
+    spec->letter = fmt[parsed_chars];
+    if (specifier_chars == 0) {
+        if (find_fmt_handler(spec->letter) == NULL) {
+            return 0;
+        }
+        // Custom conversions don't have length modifiers
+        spec->specifier = Fmt_custom;
+        spec->modifier = Modifier_None;
+        return parsed_chars + 1;
+    }
+    if (uppercase) {
+        spec->flags |= Flag_Upper;
+    }
+    return parsed_chars + specifier_chars;
+}
+
+// Address of the next field of the row, from which an argument is read
+LIBCJ_FN const void *next_field(struct Fmt_Args *const args)
+{
+    return args->row + args->offsets[args->field++];
+}
+
+// Reads the next argument from the variable argument list, or from the next field of the row,
+// which has the type of the argument before the default argument promotions
+#define FMT_ARG(args, type, promoted) \
+    (((args)->row != NULL) ? *(type const *)next_field(args) : (type)va_arg((args)->list, promoted))
+
+// Helper macros used to simplify code in __vsnprintf
+#define PRINTF_HANDLE_INT(base)                                                                                    \
+    do {                                                                                                           \
+        switch (modifier) {                                                                                        \
+        case Modifier_char:                                                                                        \
+            written += int_to_str(sink, width, precision, flags, base, true, FMT_ARG(args, char, int));            \
+            break;                                                                                                 \
+        case Modifier_short:                                                                                       \
+            written += int_to_str(sink, width, precision, flags, base, true, FMT_ARG(args, short, int));           \
+            break;                                                                                                 \
+        case Modifier_long:                                                                                        \
+            written += int_to_str(sink, width, precision, flags, base, true, FMT_ARG(args, long, long));           \
+            break;                                                                                                 \
+        case Modifier_llong:                                                                                       \
+            written += int_to_str(sink, width, precision, flags, base, true, FMT_ARG(args, long long, long long)); \
+            break;                                                                                                 \
+        case Modifier_None:                                                                                        \
+        case Modifier_ldouble:                                                                                     \
+        default:                                                                                                   \
+            written += int_to_str(sink, width, precision, flags, base, true, FMT_ARG(args, int, int));             \
+            break;                                                                                                 \
+        }                                                                                                          \
+    } while (0)
+
+#define PRINTF_HANDLE_UINT(base)                                                                                                                \
+    do {                                                                                                                                        \
+        flags = flags & (enum Fmt_Flags)~Flag_Plus; /* This flag isn't supported for unsigned numbers */                                        \
+        switch (modifier) {                                                                                                                     \
+        case Modifier_char:                                                                                                                     \
+            written += int_to_str(sink, width, precision, flags, base, false, FMT_ARG(args, unsigned char, unsigned int));                      \
+            break;                                                                                                                              \
+        case Modifier_short:                                                                                                                    \
+            written += int_to_str(sink, width, precision, flags, base, false, FMT_ARG(args, unsigned short, unsigned int));                     \
+            break;                                                                                                                              \
+        case Modifier_long:                                                                                                                     \
+            written += int_to_str(sink, width, precision, flags, base, false, (intmax_t)FMT_ARG(args, unsigned long, unsigned long));           \
+            break;                                                                                                                              \
+        case Modifier_llong:                                                                                                                    \
+            written += int_to_str(sink, width, precision, flags, base, false, (intmax_t)FMT_ARG(args, unsigned long long, unsigned long long)); \
+            break;                                                                                                                              \
+        case Modifier_None:                                                                                                                     \
+        case Modifier_ldouble:                                                                                                                  \
+        default:                                                                                                                                \
+            written += int_to_str(sink, width, precision, flags, base, false, FMT_ARG(args, unsigned int, unsigned int));                       \
+            break;                                                                                                                              \
+        }                                                                                                                                       \
+    } while (0)
+
+#define PRINTF_HANDLE_FLOAT(specifier)                                                         \
+    do {                                                                                       \
+        struct Binary_Float value;                                                             \
+        const struct Float_Format *format = &double_format;                                    \
+        switch (modifier) {                                                                    \
+        case Modifier_ldouble:                                                                 \
+            long_double_to_binary(FMT_ARG(args, long double, long double), &value);            \
+            format = LDOUBLE_BINARY_FORMAT;                                                    \
+            break;                                                                             \
+        case Modifier_None:                                                                    \
+        case Modifier_char:                                                                    \
+        case Modifier_short:                                                                   \
+        case Modifier_long:                                                                    \
+        case Modifier_llong:                                                                   \
+        default:                                                                               \
+            double_to_binary(FMT_ARG(args, double, double), &value);                           \
+            break;                                                                             \
+        }                                                                                      \
+        if (specifier == Fmt_a) {                                                              \
+            written += float_to_hex_str(sink, width, precision, flags, &value, format);        \
+        } else {                                                                               \
+            written += float_to_str(sink, width, precision, flags, specifier, &value, format); \
+        }                                                                                      \
+    } while (0)
+
+// Output of the custom conversions, which counts the characters written by the handler
+struct cj_fmt_output {
+    struct Sink *sink;
+    int written;
+};
+
+// Calls the handler registered for the letter, with a pointer read from the arguments
+// Return the amount of characters that would have been written if we had enough size
+static int custom_conversion(struct Sink *const sink, const struct Fmt_Spec *const spec, const int width, const int precision, const void *const arg)
+{
+    const struct Fmt_Handler *const handler = find_fmt_handler(spec->letter);
+    struct cj_fmt_output output = {sink, 0};
+    cj_fmt_spec info;
+    if (handler == NULL) { // Unregistered after the format was compiled
+        return 0;
+    }
+    info.width = width;
+    info.precision = precision;
+    info.left_justify = (spec->flags & Flag_Minus) != 0;
+    info.plus = (spec->flags & Flag_Plus) != 0;
+    info.space = (spec->flags & Flag_Space) != 0;
+    info.alternative = (spec->flags & Flag_Hash) != 0;
+    info.zero_pad = (spec->flags & Flag_Zero) != 0;
+    info.specifier = spec->letter;
+    handler->handler(&output, &info, arg, handler->ctx);
+    return output.written;
+}
+
+// Executes a single conversion, reading its arguments
+// Return the amount of characters that would have been written if we had enough size
+static int format_conversion(struct Sink *const sink, const struct Fmt_Spec *const spec, struct Fmt_Args *const args, const int written_so_far)
+{
+    enum Fmt_Flags flags = spec->flags;
+    const enum Length_Modifier modifier = spec->modifier;
+    const int width = (spec->width == FMT_FROM_ARGUMENT) ? FMT_ARG(args, int, int) : spec->width;
+    const int precision = (spec->precision == FMT_FROM_ARGUMENT) ? FMT_ARG(args, int, int) : spec->precision;
+    int written = 0;
+    switch (spec->specifier) {
+    case Fmt_d:
+    case Fmt_i: // Signed integer
+        PRINTF_HANDLE_INT(10);
+        break;
+    case Fmt_u: // Unsigned integer
+        PRINTF_HANDLE_UINT(10);
+        break;
+    case Fmt_o: // Unsigned integer in octal form
+        PRINTF_HANDLE_UINT(8);
+        break;
+    case Fmt_x: // Unsigned integer in hexadecimal form
+        PRINTF_HANDLE_UINT(16);
+        break;
+    case Fmt_f: // Decimal floating point
+        PRINTF_HANDLE_FLOAT(Fmt_f);
+        break;
+    case Fmt_e: // Decimal floating point in exponent form
+        PRINTF_HANDLE_FLOAT(Fmt_e);
+        break;
+    case Fmt_g: // Decimal floating point in shortest form
+        PRINTF_HANDLE_FLOAT(Fmt_g);
+        break;
+    case Fmt_a: // Floating point in hexadecimal form
+        PRINTF_HANDLE_FLOAT(Fmt_a);
+        break;
+    case Fmt_c: // Character
+        sink_putc(sink, FMT_ARG(args, char, int));
+        written++;
+        break;
+    case Fmt_s: // String
+        written += put_string(sink, width, precision, (flags & Flag_Minus), FMT_ARG(args, char *, char *));
+        break;
+    case Fmt_p: { // Pointer
+        const void *ptr = FMT_ARG(args, void *, void *);
+        if (ptr == NULL) {
+            written += put_string(sink, width, -1, (flags & Flag_Minus), "(nil)");
+        } else {
+            written += int_to_str(sink, width, precision, (flags | Flag_Hash), 16, false, (intmax_t)ptr);
+        }
+    } break;
+    case Fmt_n: { // Return the number of characters written so far
+        // TODO: Length modifiers are not implemented for %n
+        int *ptr = FMT_ARG(args, int *, int *);
+        if ((args->row == NULL) || args->store_counts) {
+            *ptr = written_so_far;
+        }
+    } break;
+    case Fmt_percent:
+        sink_putc(sink, '%');
+        written++;
+        break;
+    case Fmt_json: // String escaped for JSON
+        written += put_escaped(sink, width, precision, (flags & Flag_Minus), (flags & Flag_Hash), FMT_ARG(args, char *, char *), Escape_json);
+        break;
+    case Fmt_cstr: // String escaped for C
+        written += put_escaped(sink, width, precision, (flags & Flag_Minus), (flags & Flag_Hash), FMT_ARG(args, char *, char *), Escape_c);
+        break;
+    case Fmt_custom:
+        written += custom_conversion(sink, spec, width, precision, FMT_ARG(args, void *, void *));
+        break;
+    case Fmt_unknown:
+        break;
+    }
+    return written;
+}
+
+// Executes the next span of literal characters or conversion of the format, advancing the cursor
+// Return the amount of characters that would have been written if we had enough size
+static int interpret_step(struct Sink *const sink, const char **const cursor, struct Fmt_Args *const args, const int written_so_far)
+{
+    struct Fmt_Spec spec;
+    const char *const begin = *cursor;
+    if (*begin != '%') { // Literal characters are copied at once, up to the next specifier
+        const char *end = begin;
+        while ((*end != '\0') && (*end != '%')) {
+            end++;
+        }
+        sink_append(sink, begin, (size_t)(end - begin));
+        *cursor = end;
+        return (int)(end - begin);
+    }
+    const int parsed_chars = parse_fmt_spec(begin + 1, &spec);
+    if (parsed_chars == 0) { // Unknown specifiers are written as they are
+        sink_putc(sink, *begin);
+        *cursor = begin + 1;
+        return 1;
+    }
+    *cursor = begin + 1 + parsed_chars;
+    return format_conversion(sink, &spec, args, written_so_far);
+}
+
+// Interprets the format string while it is parsed, without null terminating the output
+static int interpret_fmt(struct Sink *const sink, const char *fmt, va_list args)
+{
+    struct Fmt_Args arguments;
+    int written = 0;
+    const char *cursor = fmt;
+    if (fmt == NULL) {
+        return -1;
+    }
+    va_copy(arguments.list, args);
+    arguments.row = NULL;
+    while (*cursor != '\0') {
+        written += interpret_step(sink, &cursor, &arguments, written);
+    }
+    va_end(arguments.list);
+    return written;
+}
+
+// Compiles the format string in up to max_ops ops, each one a literal span followed by a conversion
+// Return the amount of ops, or -1 if the format has too many conversions
+static int compile_ops(const char *const fmt, cj_fmt_op *const ops, const int max_ops)
+{
+    const char *cursor = fmt;
+    const char *literal = fmt;
+    int count = 0;
+    for (;;) {
+        struct Fmt_Spec spec;
+        int parsed_chars = 0;
+        while ((*cursor != '\0') && (*cursor != '%')) {
+            cursor++;
+        }
+        if (*cursor == '%') {
+            parsed_chars = parse_fmt_spec(cursor + 1, &spec);
+            if (parsed_chars == 0) { // Unknown specifiers are part of the literal span
+                cursor++;
+                continue;
+            }
+        } else {
+            spec.specifier = Fmt_unknown; // End of the format string
+        }
+        if ((count == max_ops) || ((size_t)(cursor - fmt) > UINT32_MAX)) {
+            return -1;
+        }
+        cj_fmt_op *const op = &ops[count++];
+        op->literal_begin = (uint32_t)(literal - fmt);
+        op->literal_length = (uint32_t)(cursor - literal);
+        op->specifier = (unsigned char)spec.specifier;
+        if (spec.specifier == Fmt_unknown) {
+            return count;
+        }
+        op->flags = (unsigned char)spec.flags;
+        op->letter = (unsigned char)spec.letter;
+        op->modifier = (unsigned char)spec.modifier;
+        op->width = spec.width;
+        op->precision = spec.precision;
+        cursor += 1 + parsed_chars;
+        literal = cursor;
+    }
+}
+
+// Compiles the format string in a list of literal spans, each one followed by a conversion
+// If the format has too many conversions, the count is -1 and it is interpreted when executed
+// This function isn't defined by standard-C
+cj_fmt_compiled cj_fmt_compile(const char *fmt)
+{
+    cj_fmt_compiled compiled;
+    compiled.fmt = fmt;
+    compiled.count = (fmt != NULL) ? compile_ops(fmt, compiled.ops, CJ_FMT_MAX_OPS) : -1;
+    return compiled;
+}
+
+// Executes the ops of a format, or interprets it if count is negative (it couldn't be compiled)
+// The characters written before are counted in written_so_far, for %n
+// Return the amount of characters that would have been written if we had enough size
+static int execute_op_list(struct Sink *const sink, const char *const fmt, const cj_fmt_op *const ops, const int count,
+    struct Fmt_Args *const args, const int written_so_far)
+{
+    int written = written_so_far;
+    if (count < 0) {
+        const char *cursor = fmt;
+        while (*cursor != '\0') {
+            written += interpret_step(sink, &cursor, args, written);
+        }
+        return written - written_so_far;
+    }
+    for (int index = 0; index < count; index++) {
+        const cj_fmt_op *const op = &ops[index];
+        sink_append(sink, &fmt[op->literal_begin], op->literal_length);
+        written += (int)op->literal_length;
+        if (op->specifier != Fmt_unknown) {
+            const struct Fmt_Spec spec = {
+                (enum Fmt_Flags)op->flags, op->width, op->precision,
+                (enum Fmt_Specifier)op->specifier, (enum Length_Modifier)op->modifier, (char)op->letter,
+            };
+            written += format_conversion(sink, &spec, args, written);
+        }
+    }
+    return written - written_so_far;
+}
+
+// Executes the ops of the compiled format, or interprets it if it couldn't be compiled
+static int execute_ops(struct Sink *const sink, const cj_fmt_compiled *const compiled, struct Fmt_Args *const args, const int written_so_far)
+{
+    return execute_op_list(sink, compiled->fmt, compiled->ops, compiled->count, args, written_so_far);
+}
+
+// Executes the ops of a format, without parsing it again nor null terminating the output
+static int execute_fmt(struct Sink *const sink, const char *const fmt, const cj_fmt_op *const ops, const int count, va_list args)
+{
+    struct Fmt_Args arguments;
+    if (fmt == NULL) {
+        return -1;
+    }
+    va_copy(arguments.list, args);
+    arguments.row = NULL;
+    const int written = execute_op_list(sink, fmt, ops, count, &arguments, 0);
+    va_end(arguments.list);
+    return written;
+}
+
+#ifndef LIBCJ_NO_FMT_CACHE
+// Thread local cache of the formats compiled by __vsnprintf, indexed by the address of the format
+// The text of the format is kept too, because the same address may hold another format later
+// Entries have room for fewer ops than cj_fmt_compiled, formats with more conversions are interpreted
+// Each thread takes FMT_CACHE_SIZE * sizeof(struct Fmt_Cache_Entry), about 5 KB on 64-bit targets
+#define FMT_CACHE_SIZE       16 // Must be a power of two
+#define FMT_CACHE_MAX_LENGTH 128
+#define FMT_CACHE_MAX_OPS    8
+
+struct Fmt_Cache_Entry {
+    const char *fmt; // NULL if the entry is empty
+    cj_fmt_op ops[FMT_CACHE_MAX_OPS];
+    int count;
+    unsigned short users; // Entries in use can't be replaced, as callbacks may print while they are executed
+    unsigned generation; // Of the custom conversions when the format was compiled
+    char text[FMT_CACHE_MAX_LENGTH];
+};
+
+static THREAD_LOCAL struct Fmt_Cache_Entry fmt_cache[FMT_CACHE_SIZE];
+static THREAD_LOCAL cj_fmt_cache_stats fmt_cache_stats;
+
+// Returns the entry with the compiled format, or NULL if it can't be cached
+static struct Fmt_Cache_Entry *fmt_cache_lookup(const char *const fmt)
+{
+    const uintptr_t address = (uintptr_t)fmt;
+    struct Fmt_Cache_Entry *const entry = &fmt_cache[((address >> 4) ^ (address >> 12)) & (FMT_CACHE_SIZE - 1)];
+    if ((entry->fmt == fmt) && (entry->generation == fmt_handlers_generation) &&
+        (strncmp(entry->text, fmt, FMT_CACHE_MAX_LENGTH) == 0)) {
+        fmt_cache_stats.hits++;
+        return entry;
+    }
+    fmt_cache_stats.misses++;
+    const size_t length = strlen(fmt);
+    if ((length >= FMT_CACHE_MAX_LENGTH) || (entry->users > 0)) {
+        return NULL;
+    }
+    entry->count = compile_ops(fmt, entry->ops, FMT_CACHE_MAX_OPS);
+    if (entry->count < 0) {
+        entry->fmt = NULL;
+        return NULL;
+    }
+    entry->fmt = fmt;
+    memcpy(entry->text, fmt, length + 1);
+    entry->generation = fmt_handlers_generation;
+    return entry;
+}
+#endif // LIBCJ_NO_FMT_CACHE
+
+// Statistics of the format cache of the calling thread (zeros if the cache is disabled)
+// This function isn't defined by standard-C
+cj_fmt_cache_stats cj_fmt_cache_get_stats(void)
+{
+#ifndef LIBCJ_NO_FMT_CACHE
+    return fmt_cache_stats;
+#else
+    return (cj_fmt_cache_stats){0, 0};
+#endif // LIBCJ_NO_FMT_CACHE
+}
+
+// Formats with the cached compiled format, or interprets it, without null terminating the output
+// Nested formatting (as cj_fmt_writef) must not terminate, the sink may have no byte reserved for it
+static int format_to_sink(struct Sink *const sink, const char *fmt, va_list args)
+{
+    if (fmt == NULL) {
+        return -1;
+    }
+#ifndef LIBCJ_NO_FMT_CACHE
+    struct Fmt_Cache_Entry *const entry = fmt_cache_lookup(fmt);
+    if (entry != NULL) {
+        entry->users++;
+        const int written = execute_fmt(sink, entry->fmt, entry->ops, entry->count, args);
+        entry->users--;
+        return written;
+    }
+#endif // LIBCJ_NO_FMT_CACHE
+    return interpret_fmt(sink, fmt, args);
+}
+
+static int __vsnprintf(struct Sink *const sink, const char *fmt, va_list args)
+{
+    if (fmt == NULL) {
+        return -1;
+    }
+    const int written = format_to_sink(sink, fmt, args);
+    sink_terminate(sink);
+    return written;
+}
+
+// Write formatted output of a compiled format to sized buffer. This function isn't defined by standard-C
+int cj_fmt_snprintf(const cj_fmt_compiled *compiled, char *buf, size_t sz, ...)
+{
+    va_list args;
+    va_start(args, sz);
+    const int written = cj_fmt_vsnprintf(compiled, buf, sz, args);
+    va_end(args);
+    return written;
+}
+
+// Write formatted output of a compiled format from variable argument list to sized buffer
+// This function isn't defined by standard-C
+int cj_fmt_vsnprintf(const cj_fmt_compiled *compiled, char *buf, size_t sz, va_list args)
+{
+    struct Sink sink;
+    if (compiled->fmt == NULL) {
+        return -1;
+    }
+    sink_buffer(&sink, buf, &sz);
+    const int written = execute_fmt(&sink, compiled->fmt, compiled->ops, compiled->count, args);
+    sink_terminate(&sink);
+    return written;
+}
+
+// Registers the handler of a custom conversion, for a letter that isn't a conversion or length
+// modifier of the standard, or removes it if the handler is NULL. The conversion reads a pointer argument
+// It must not be called while other threads are formatting. This function isn't defined by standard-C
+// Returns 0 on success, or -1 if the letter can't be used
+int cj_fmt_register(char specifier, cj_fmt_handler handler, void *ctx)
+{
+    if (!isalpha((unsigned char)specifier) || (strchr("diouxXfFeEgGaAcspnJQhlLqjzt", specifier) != NULL)) {
+        return -1;
+    }
+    fmt_handlers[(unsigned char)specifier].handler = handler;
+    fmt_handlers[(unsigned char)specifier].ctx = ctx;
+    fmt_handlers_generation++;
+    return 0;
+}
+
+// Writes len characters to the output of a custom conversion. This function isn't defined by standard-C
+void cj_fmt_write(cj_fmt_output *out, const char *str, size_t len)
+{
+    sink_append(out->sink, str, len);
+    out->written += (int)len;
+}
+
+// Writes the string to the output of a custom conversion, with the width and precision of the
+// conversion applied like %s does. This function isn't defined by standard-C
+void cj_fmt_write_padded(cj_fmt_output *out, const cj_fmt_spec *spec, const char *str)
+{
+    out->written += put_string(out->sink, spec->width, spec->precision, spec->left_justify, str);
+}
+
+// Writes formatted output to the output of a custom conversion. This function isn't defined by standard-C
+int cj_fmt_writef(cj_fmt_output *out, const char *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    // The output continues after the conversion, so it isn't null terminated
+    const int written = format_to_sink(out->sink, fmt, args);
+    va_end(args);
+    if (written > 0) {
+        out->written += written;
+    }
+    return written;
+}
+
+// Amount of characters that snprintf would write with a large enough buffer (without the null termination)
+// The conversions only compute the length of their output. This function isn't defined by standard-C
+int cj_fmt_length(const char *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    const int length = cj_fmt_vlength(fmt, args);
+    va_end(args);
+    return length;
+}
+
+// Amount of characters that vsnprintf would write with a large enough buffer (without the null termination)
+// This function isn't defined by standard-C
+int cj_fmt_vlength(const char *fmt, va_list args)
+{
+    struct Sink sink;
+    sink_counter(&sink);
+    return __vsnprintf(&sink, fmt, args);
+}
+
+// Size of the scratch buffer in which cj_fmt_resume discards single characters already written
+#define RESUME_SCRATCH_SIZE 64
+
+// Sink of cj_fmt_resume: the first characters go to a scratch buffer and are discarded, and the
+// remaining ones are written to the output buffer, without null termination. Runs of characters
+// that are appended or filled are discarded at once, without going through the scratch buffer
+struct Resume_Context {
+    char scratch[RESUME_SCRATCH_SIZE];
+    size_t skip; // Characters still to be discarded after the ones in the scratch buffer
+    size_t skipped; // Characters discarded before the ones in the scratch buffer
+    char *buf;
+    size_t sz;
+    bool attached; // Set when the sink writes to the output buffer
+};
+
+static bool resume_sink_overflow(struct Sink *const sink)
+{
+    struct Resume_Context *const context = sink->context;
+    if (context->attached) {
+        return false;
+    }
+    context->skipped += (size_t)(sink->cursor - context->scratch);
+    if (context->skip > 0) {
+        sink->cursor = context->scratch;
+        sink->room = MIN(context->skip, sizeof(context->scratch));
+        context->skip -= sink->room;
+    } else {
+        sink->cursor = context->buf;
+        sink->room = context->sz;
+        context->attached = true;
+    }
+    return true;
+}
+
+// Discards up to len of the characters that are still to be skipped, before the sink is attached,
+// returning how many. Those in the room of the scratch buffer are only counted
+LIBCJ_FN size_t resume_sink_skip(struct Sink *const sink, const size_t len)
+{
+    struct Resume_Context *const context = sink->context;
+    const size_t in_room = MIN(len, sink->room);
+    const size_t beyond = MIN(len - in_room, context->skip);
+    sink->cursor += in_room;
+    sink->room -= in_room;
+    context->skip -= beyond;
+    context->skipped += beyond;
+    return in_room + beyond;
+}
+
+static bool resume_sink_write_through(struct Sink *const sink, const char *const str, const size_t len)
+{
+    if (((struct Resume_Context *)sink->context)->attached) {
+        return false;
+    }
+    const size_t skipped = resume_sink_skip(sink, len);
+    if ((skipped < len) && resume_sink_overflow(sink)) {
+        sink_append(sink, &str[skipped], len - skipped);
+    }
+    return true;
+}
+
+static bool resume_sink_fill_through(struct Sink *const sink, const char c, const size_t len)
+{
+    if (((struct Resume_Context *)sink->context)->attached) {
+        return false;
+    }
+    const size_t skipped = resume_sink_skip(sink, len);
+    if ((skipped < len) && resume_sink_overflow(sink)) {
+        const size_t fit = MIN(len - skipped, sink->room);
+        memset(sink->cursor, c, fit);
+        sink->cursor += fit;
+        sink->room -= fit;
+    }
+    return true;
+}
+
+// Amount of characters received by the sink, including the discarded ones
+LIBCJ_FN size_t resume_sink_received(const struct Sink *const sink)
+{
+    const struct Resume_Context *const context = sink->context;
+    return context->skipped + (size_t)(sink->cursor - (context->attached ? context->buf : context->scratch));
+}
+
+// Writes the characters of a part of the output from the first skip ones (count copies of c if str
+// is NULL) while there is room. Returns false when the buffer is full before its end, and then skip
+// is the amount of its characters written. Otherwise skip is what is left to skip after it
+LIBCJ_FN bool resume_part(struct Sink *const sink, size_t *const skip, const char *const str, const char c, const size_t count)
+{
+    if (*skip >= count) {
+        *skip -= count;
+        return true;
+    }
+    const size_t fit = MIN(count - *skip, sink->room);
+    if (str != NULL) {
+        memcpy(sink->cursor, &str[*skip], fit);
+    } else {
+        memset(sink->cursor, c, fit);
+    }
+    sink->cursor += fit;
+    sink->room -= fit;
+    if ((*skip + fit) < count) {
+        *skip += fit;
+        return false;
+    }
+    *skip = 0;
+    return true;
+}
+
+// Writes the characters of the string (escaped for %J and %Q) from state->source while there is
+// room, reading it only up to the room. state->skip are the characters of the escape sequence
+// of the first one that were already written. Returns true when the end of the string is reached
+static bool resume_string_body(struct Sink *const sink, cj_fmt_state *const state, const char *const string, const int precision, const enum Fmt_Specifier specifier)
+{
+    const enum Escape_Style style = (specifier == Fmt_json) ? Escape_json : Escape_c;
+    while (sink->room > 0) {
+        const char *const str = &string[state->source];
+        // Each character takes at least one in the room, so room + 1 of them tell if it ends here
+        size_t bound = MIN(sink->room + 1, INT_MAX);
+        bool limited = false;
+        if ((precision >= 0) && (((size_t)precision - state->source) <= bound)) {
+            bound = (size_t)precision - state->source;
+            limited = true;
+        }
+        const size_t len = string_length(str, (int)bound);
+        size_t index = 0;
+        while ((index < len) && (sink->room > 0)) {
+            const size_t end = (specifier == Fmt_s) ? len : find_escape(str, index, len, style);
+            const size_t fit = MIN(end - index, sink->room);
+            memcpy(sink->cursor, &str[index], fit);
+            sink->cursor += fit;
+            sink->room -= fit;
+            index += fit;
+            if (index < len) {
+                char sequence[6];
+                const size_t sequence_len = escape_sequence(sequence, (unsigned char)str[index], style);
+                if ((index < end) || !resume_part(sink, &state->skip, sequence, '\0', sequence_len)) {
+                    break;
+                }
+                index++;
+            }
+        }
+        state->source += index;
+        if (index < len) {
+            return false;
+        }
+        if ((len < bound) || limited) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Writes the rest of a string conversion (%s, %J or %Q) from the progress in the state, which
+// is updated with the characters written. Only the part of the string that fits is read, and the
+// padding is found from its first width characters. Returns true once the conversion is complete
+static bool resume_string(struct Sink *const sink, cj_fmt_state *const state, const struct Fmt_Spec *const spec, const int width, int precision, const char *string)
+{
+    enum Fmt_Specifier specifier = spec->specifier;
+    if (string == NULL) { // Escaped conversions print it without quotes nor precision
+        precision = (specifier == Fmt_s) ? precision : -1;
+        specifier = Fmt_s;
+        string = "(null)";
+    }
+    const size_t quotes = ((specifier != Fmt_s) && ((spec->flags & Flag_Hash) != 0)) ? 1 : 0;
+    if (state->padding < 0) {
+        state->padding = 0;
+        if (width > (int)(2 * quotes)) {
+            const size_t len = string_length(string, ((precision >= 0) && (precision < width)) ? precision : width);
+            struct Sink counter;
+            sink_counter(&counter);
+            const size_t body = (specifier == Fmt_s) ? len : escape_to_sink(&counter, string, len, (specifier == Fmt_json) ? Escape_json : Escape_c);
+            state->padding = (body < (size_t)width) ? MAX(width - (int)(2 * quotes) - (int)body, 0) : 0;
+        }
+    }
+    const bool left_justify = (spec->flags & Flag_Minus) != 0;
+    const size_t left = left_justify ? 0 : (size_t)state->padding;
+    const size_t right = left_justify ? (size_t)state->padding : 0;
+    size_t skip = state->skip;
+    if (state->source == 0) { // The characters before the string are counted in the skip
+        if (!resume_part(sink, &skip, NULL, ' ', left)) {
+            state->skip = skip;
+            return false;
+        }
+        if (!resume_part(sink, &skip, "\"", '\0', quotes)) {
+            state->skip = left + skip;
+            return false;
+        }
+    }
+    const size_t before = (state->source == 0) ? (left + quotes) : 0;
+    state->skip = skip;
+    if (!resume_string_body(sink, state, string, precision, specifier)) {
+        state->skip += (state->source == 0) ? before : 0;
+        return false;
+    }
+    skip = state->skip;
+    if (!resume_part(sink, &skip, "\"", '\0', quotes)) {
+        state->skip = ((state->source == 0) ? before : 0) + skip;
+        return false;
+    }
+    if (!resume_part(sink, &skip, NULL, ' ', right)) {
+        state->skip = ((state->source == 0) ? before : 0) + quotes + skip;
+        return false;
+    }
+    return true;
+}
+
+// Starts formatting into several buffers. The arguments are copied, but they must stay valid
+// until cj_fmt_state_end, so the state can't outlive the function that received them
+// This function isn't defined by standard-C
+void cj_fmt_state_init(cj_fmt_state *state, const char *fmt, va_list args)
+{
+    state->fmt = fmt;
+    va_copy(state->args, args);
+    state->skip = 0;
+    state->source = 0;
+    state->padding = -1;
+    state->written = 0;
+}
+
+void cj_fmt_state_end(cj_fmt_state *state)
+{
+    va_end(state->args);
+}
+
+// Continues formatting from where the previous call stopped, filling the buffer (without null termination)
+// String conversions continue from the character of the string where they stopped. Other conversions
+// that don't fit are executed again in the next call, discarding the characters already written
+// Return the amount of characters written to the buffer, which is zero once the output is complete
+// This function isn't defined by standard-C
+size_t cj_fmt_resume(cj_fmt_state *state, char *buf, size_t sz)
+{
+    struct Resume_Context context;
+    struct Sink sink;
+    if ((state->fmt == NULL) || (sz == 0)) {
+        return 0;
+    }
+    context.skip = (state->padding < 0) ? state->skip : 0;
+    context.skipped = 0;
+    context.buf = buf;
+    context.sz = sz;
+    context.attached = false;
+    sink.cursor = context.scratch;
+    sink.room = 0;
+    sink.overflow = resume_sink_overflow;
+    sink.write_through = resume_sink_write_through;
+    sink.fill_through = resume_sink_fill_through;
+    sink.context = &context;
+    resume_sink_overflow(&sink);
+    while ((*state->fmt != '\0') && !(context.attached && (sink.room == 0))) {
+        struct Fmt_Args arguments;
+        struct Fmt_Spec spec;
+        const char *cursor = state->fmt;
+        const size_t received = resume_sink_received(&sink);
+        const int parsed_chars = (*cursor == '%') ? parse_fmt_spec(cursor + 1, &spec) : 0;
+        va_copy(arguments.list, state->args);
+        arguments.row = NULL;
+        if ((parsed_chars > 0) && ((spec.specifier == Fmt_s) || (spec.specifier == Fmt_json) || (spec.specifier == Fmt_cstr))) {
+            // The arguments are read again until the conversion is complete
+            const int width = (spec.width == FMT_FROM_ARGUMENT) ? FMT_ARG(&arguments, int, int) : spec.width;
+            const int precision = (spec.precision == FMT_FROM_ARGUMENT) ? FMT_ARG(&arguments, int, int) : spec.precision;
+            const char *const string = FMT_ARG(&arguments, char *, char *);
+            const bool complete = resume_string(&sink, state, &spec, width, precision, string);
+            state->written += (int)(resume_sink_received(&sink) - received);
+            if (!complete) {
+                va_end(arguments.list);
+                break;
+            }
+            cursor += 1 + parsed_chars;
+        } else {
+            const int length = interpret_step(&sink, &cursor, &arguments, state->written);
+            const size_t delivered = resume_sink_received(&sink) - received;
+            if (delivered < (size_t)length) { // The buffer is full, the arguments of this step are read again next time
+                va_end(arguments.list);
+                state->skip = delivered;
+                break;
+            }
+            state->written += length;
+        }
+        va_end(state->args);
+        va_copy(state->args, arguments.list);
+        va_end(arguments.list);
+        state->fmt = cursor;
+        state->skip = 0;
+        state->source = 0;
+        state->padding = -1;
+    }
+    return context.attached ? (size_t)(sink.cursor - buf) : 0;
+}
+
+// Formats the rows from first to last (exclusive), reading the arguments from their fields
+// %n stores nothing when written_so_far is unknown (NULL), otherwise it counts the characters written before
+// Return the amount of characters that would have been written if we had enough size
+static size_t format_rows(struct Sink *const sink, const cj_fmt_compiled *const compiled, const char *const base,
+    const size_t stride, const size_t first, const size_t last, const size_t *const field_offsets, const size_t *const written_so_far)
+{
+    struct Fmt_Args arguments;
+    const size_t start = (written_so_far != NULL) ? *written_so_far : 0;
+    size_t written = start;
+    arguments.offsets = field_offsets;
+    arguments.store_counts = written_so_far != NULL;
+    for (size_t index = first; index < last; index++) {
+        arguments.row = &base[index * stride];
+        arguments.field = 0;
+        written += (size_t)execute_ops(sink, compiled, &arguments, (int)MIN(written, INT_MAX));
+    }
+    return written - start;
+}
+
+// Formats an array of rows (usually structs) with the same format into a single buffer
+// The arguments of each row are read from the fields at the given offsets, one for each argument
+// (including widths and precisions given by '*'), that have the types expected by the format
+// before the default argument promotions (%c reads a char and %hd a short, for instance)
+// Return the amount of characters that would have been written if we had enough size
+// This function isn't defined by standard-C
+int cj_format_rows(const cj_fmt_compiled *compiled, const void *base, size_t stride, size_t nrows,
+    const size_t *field_offsets, char *out, size_t cap)
+{
+    struct Sink sink;
+    if (compiled->fmt == NULL) {
+        return -1;
+    }
+    sink_buffer(&sink, out, &cap);
+    const size_t written_so_far = 0;
+    const size_t written = format_rows(&sink, compiled, base, stride, 0, nrows, field_offsets, &written_so_far);
+    sink_terminate(&sink);
+    return (written > INT_MAX) ? -1 : (int)written;
+}
+
+#ifdef LIBCJ_POSIX
+// Maximum amount of threads used by cj_format_rows_parallel
+#define FORMAT_ROWS_MAX_THREADS 64
+
+// Barrier between the two passes of cj_format_rows_parallel, so that the same threads run both
+struct Rows_Barrier {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    size_t counted; // Threads that have computed the length of their chunk
+    bool released; // The offsets of the chunks are known
+    bool write; // The second pass is needed
+};
+
+// Chunk of rows formatted by one of the threads of cj_format_rows_parallel
+struct Rows_Task {
+    const cj_fmt_compiled *compiled;
+    const char *base;
+    size_t stride;
+    size_t first;
+    size_t last;
+    const size_t *field_offsets;
+    char *out;
+    size_t cap;
+    size_t offset; // Position of the chunk in the output
+    size_t length; // Length of the output of the chunk
+    struct Rows_Barrier *barrier;
+    pthread_t thread;
+    bool started;
+};
+
+// The first pass of cj_format_rows_parallel computes the length of each chunk
+// %n stores nothing yet, as the position of the chunk in the output isn't known
+static void rows_task_count(struct Rows_Task *const task)
+{
+    struct Sink sink;
+    sink_counter(&sink);
+    task->length = format_rows(&sink, task->compiled, task->base, task->stride, task->first, task->last, task->field_offsets, NULL);
+}
+
+// The second pass writes each chunk at its final position, without null termination
+static void rows_task_write(struct Rows_Task *const task)
+{
+    struct Sink sink;
+    const size_t room = ((task->cap > 0) && (task->offset < (task->cap - 1))) ? MIN(task->length, task->cap - 1 - task->offset) : 0;
+    sink_counter(&sink);
+    if (room > 0) {
+        sink.cursor = &task->out[task->offset];
+        sink.room = room;
+    }
+    format_rows(&sink, task->compiled, task->base, task->stride, task->first, task->last, task->field_offsets, &task->offset);
+}
+
+// Runs both passes for the chunk of the task, waiting for the offsets of all the chunks between them
+static void *rows_task_run(void *const arg)
+{
+    struct Rows_Task *const task = arg;
+    struct Rows_Barrier *const barrier = task->barrier;
+    rows_task_count(task);
+    pthread_mutex_lock(&barrier->mutex);
+    barrier->counted++;
+    pthread_cond_broadcast(&barrier->cond);
+    while (!barrier->released) {
+        pthread_cond_wait(&barrier->cond, &barrier->mutex);
+    }
+    const bool write = barrier->write;
+    pthread_mutex_unlock(&barrier->mutex);
+    if (write) {
+        rows_task_write(task);
+    }
+    return NULL;
+}
+
+// Returns true if the format has %n conversions, that need the second pass even without output
+static bool fmt_stores_count(const char *const fmt)
+{
+    for (const char *cursor = strchr(fmt, '%'); cursor != NULL; cursor = strchr(cursor, '%')) {
+        struct Fmt_Spec spec;
+        const int parsed_chars = parse_fmt_spec(cursor + 1, &spec);
+        if ((parsed_chars > 0) && (spec.specifier == Fmt_n)) {
+            return true;
+        }
+        cursor += 1 + parsed_chars;
+    }
+    return false;
+}
+#endif // LIBCJ_POSIX
+
+// Same as cj_format_rows, splitting the rows in chunks formatted by up to 'threads' threads
+// The length of each chunk is computed first, so that they are written in order straight to the output
+// Each thread formats its chunk in both passes, and a task whose thread can't be created is run by
+// the calling thread. Without POSIX threads, the rows are formatted by the calling thread
+// This function isn't defined by standard-C
+int cj_format_rows_parallel(const cj_fmt_compiled *compiled, const void *base, size_t stride, size_t nrows,
+    const size_t *field_offsets, char *out, size_t cap, unsigned threads)
+{
+#ifdef LIBCJ_POSIX
+    struct Rows_Task tasks[FORMAT_ROWS_MAX_THREADS];
+    struct Rows_Barrier barrier;
+    const size_t count = MIN(MIN((size_t)threads, (size_t)FORMAT_ROWS_MAX_THREADS), nrows);
+    if ((count <= 1) || (compiled->fmt == NULL) || (pthread_mutex_init(&barrier.mutex, NULL) != 0)) {
+        return cj_format_rows(compiled, base, stride, nrows, field_offsets, out, cap);
+    }
+    if (pthread_cond_init(&barrier.cond, NULL) != 0) {
+        pthread_mutex_destroy(&barrier.mutex);
+        return cj_format_rows(compiled, base, stride, nrows, field_offsets, out, cap);
+    }
+    barrier.counted = 0;
+    barrier.released = false;
+    barrier.write = false;
+    for (size_t i = 0; i < count; i++) {
+        tasks[i].compiled = compiled;
+        tasks[i].base = base;
+        tasks[i].stride = stride;
+        tasks[i].first = (nrows * i) / count;
+        tasks[i].last = (nrows * (i + 1)) / count;
+        tasks[i].field_offsets = field_offsets;
+        tasks[i].out = out;
+        tasks[i].cap = cap;
+        tasks[i].barrier = &barrier;
+        tasks[i].started = false;
+    }
+    size_t started = 0;
+    for (size_t i = 1; i < count; i++) {
+        tasks[i].started = pthread_create(&tasks[i].thread, NULL, rows_task_run, &tasks[i]) == 0;
+        started += tasks[i].started ? 1 : 0;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (!tasks[i].started) {
+            rows_task_count(&tasks[i]);
+        }
+    }
+    size_t written = 0;
+    pthread_mutex_lock(&barrier.mutex);
+    while (barrier.counted < started) {
+        pthread_cond_wait(&barrier.cond, &barrier.mutex);
+    }
+    for (size_t i = 0; i < count; i++) {
+        tasks[i].offset = written;
+        written += tasks[i].length;
+    }
+    barrier.write = (cap > 0) || fmt_stores_count(compiled->fmt);
+    barrier.released = true;
+    pthread_cond_broadcast(&barrier.cond);
+    pthread_mutex_unlock(&barrier.mutex);
+    for (size_t i = 0; i < count; i++) {
+        if (!tasks[i].started && barrier.write) {
+            rows_task_write(&tasks[i]);
+        }
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (tasks[i].started) {
+            pthread_join(tasks[i].thread, NULL);
+        }
+    }
+    pthread_cond_destroy(&barrier.cond);
+    pthread_mutex_destroy(&barrier.mutex);
+    if (cap > 0) {
+        out[MIN(written, cap - 1)] = '\0';
+    }
+    return (written > INT_MAX) ? -1 : (int)written;
+#else
+    (void)threads;
+    return cj_format_rows(compiled, base, stride, nrows, field_offsets, out, cap);
+#endif // LIBCJ_POSIX
+}
+
+// Writes a single argument of cj_print, with the conversion selected by its type
+// Return the amount of characters that would have been written if we had enough size
+static int print_arg(struct Sink *const sink, const cj_arg *const arg)
+{
+    const bool left_justify = arg->width < 0;
+    const int width = left_justify ? ((arg->width == INT_MIN) ? INT_MAX : -arg->width) : arg->width;
+    const enum Fmt_Flags flags = left_justify ? Flag_Minus : Flag_None;
+    const int base = arg->hex ? 16 : 10;
+    switch ((cj_arg_type)arg->type) {
+    case CJ_ARG_INT:
+        if (arg->hex) { // Written as the unsigned integer of the same size, like %x
+            const unsigned bits = CHAR_BIT * arg->size;
+            const unsigned long long mask = (bits < 64) ? ((1ULL << bits) - 1) : ~0ULL;
+            return int_to_str(sink, width, arg->precision, flags, base, false, (intmax_t)(arg->value.u & mask));
+        }
+        return int_to_str(sink, width, arg->precision, flags, base, true, arg->value.i);
+    case CJ_ARG_UINT:
+        return int_to_str(sink, width, arg->precision, flags, base, false, (intmax_t)arg->value.u);
+    case CJ_ARG_DOUBLE:
+    case CJ_ARG_LDOUBLE: {
+        struct Binary_Float value;
+        const struct Float_Format *format = &double_format;
+        if (arg->type == CJ_ARG_LDOUBLE) {
+            long_double_to_binary(arg->lf, &value);
+            format = LDOUBLE_BINARY_FORMAT;
+        } else {
+            double_to_binary(arg->value.f, &value);
+        }
+        if (arg->hex) {
+            return float_to_hex_str(sink, width, arg->precision, flags, &value, format);
+        }
+        const enum Fmt_Specifier specifier = (arg->precision >= 0) ? Fmt_f : Fmt_g;
+        return float_to_str(sink, width, arg->precision, flags, specifier, &value, format);
+    }
+    case CJ_ARG_CHAR: {
+        const int padding = width - 1;
+        if (!left_justify) {
+            sink_fill(sink, ' ', padding);
+        }
+        sink_putc(sink, (char)arg->value.i);
+        if (left_justify) {
+            sink_fill(sink, ' ', padding);
+        }
+        return 1 + MAX(padding, 0);
+    }
+    case CJ_ARG_STR:
+        return put_string(sink, width, arg->precision, left_justify, arg->value.s);
+    case CJ_ARG_PTR:
+        if (arg->value.p == NULL) {
+            return put_string(sink, width, -1, left_justify, "(nil)");
+        }
+        return int_to_str(sink, width, arg->precision, (flags | Flag_Hash), 16, false, (intmax_t)arg->value.p);
+    case CJ_ARG_END:
+        break;
+    }
+    return 0;
+}
+
+// Write the arguments, terminated by one of type CJ_ARG_END, to sized buffer
+// This function is called by the cj_print macro, and isn't defined by standard-C
+int cj_print_args(char *buf, size_t sz, const cj_arg *args)
+{
+    struct Sink sink;
+    sink_buffer(&sink, buf, &sz);
+    int written = 0;
+    for (; args->type != CJ_ARG_END; args++) {
+        written += print_arg(&sink, args);
+    }
+    sink_terminate(&sink);
+    return written;
+}
+
+// Size of the chunk in which cj_vcbprintf formats the output before passing it to the callback
+#define CALLBACK_CHUNK_SIZE 512
+
+struct Callback_Context {
+    cj_print_callback callback;
+    void *ctx;
+    char chunk[CALLBACK_CHUNK_SIZE];
+};
+
+// Passes the formatted chunk to the callback and starts over at the beginning of the chunk
+static bool callback_flush(struct Sink *const sink)
+{
+    struct Callback_Context *const context = sink->context;
+    const size_t len = (size_t)(sink->cursor - context->chunk);
+    if (len > 0) {
+        context->callback(context->ctx, context->chunk, len);
+    }
+    sink->cursor = context->chunk;
+    sink->room = sizeof(context->chunk) - 1; // The null termination is never passed to the callback
+    return true;
+}
+
+// Sink that formats in the chunk of the context, and passes it to the callback when it's full
+LIBCJ_FN void callback_sink(struct Sink *const sink, struct Callback_Context *const context, const cj_print_callback cb, void *const ctx)
+{
+    context->callback = cb;
+    context->ctx = ctx;
+    sink->cursor = context->chunk;
+    sink->room = sizeof(context->chunk) - 1;
+    sink->overflow = callback_flush;
+    sink->write_through = NULL;
+    sink->fill_through = NULL;
+    sink->context = context;
+}
+
+// Write formatted data to a callback, in chunks of constant size. This function isn't defined by standard-C
+int cj_cbprintf(cj_print_callback cb, void *ctx, const char *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    const int written = cj_vcbprintf(cb, ctx, fmt, args);
+    va_end(args);
+    return written;
+}
+
+// Write formatted data from variable argument list to a callback. This function isn't defined by standard-C
+int cj_vcbprintf(cj_print_callback cb, void *ctx, const char *fmt, va_list args)
+{
+    struct Callback_Context context;
+    struct Sink sink;
+    if (cb == NULL) {
+        return -1;
+    }
+    callback_sink(&sink, &context, cb, ctx);
+    const int written = __vsnprintf(&sink, fmt, args);
+    callback_flush(&sink);
+    return written;
+}
+
+// Largest size of the arguments of a record of cj_log_capture, including the copied strings
+#define LOG_MAX_PAYLOAD 1024
+// Each op of a compiled format reads up to 3 arguments: width, precision and value
+#define LOG_MAX_ARGS (3 * CJ_FMT_MAX_OPS)
+// Records start with the index of the format and the size of the payload, as 32-bit integers
+#define LOG_HEADER_SIZE (2 * sizeof(uint32_t))
+
+// Arguments captured by cj_log_capture, with the types read by format_conversion
+enum Log_Arg {
+    Log_none,
+    Log_char, Log_short, Log_int, Log_long, Log_llong,
+    Log_double, Log_ldouble, Log_pointer,
+    Log_string, // Copied to the record with its null termination
+    Log_count, // Pointer of %n, that isn't captured
+    Log_unsupported
+};
+
+// Returns the argument read by the conversion of the op (besides its width and precision)
+LIBCJ_FN enum Log_Arg log_arg(const cj_fmt_op *const op)
+{
+    switch ((enum Fmt_Specifier)op->specifier) {
+    case Fmt_d:
+    case Fmt_i:
+    case Fmt_u:
+    case Fmt_o:
+    case Fmt_x:
+        switch ((enum Length_Modifier)op->modifier) {
+        case Modifier_char:  return Log_char;
+        case Modifier_short: return Log_short;
+        case Modifier_long:  return Log_long;
+        case Modifier_llong: return Log_llong;
+        case Modifier_None:
+        case Modifier_ldouble:
+        default: return Log_int;
+        }
+    case Fmt_f:
+    case Fmt_e:
+    case Fmt_g:
+    case Fmt_a: return (op->modifier == Modifier_ldouble) ? Log_ldouble : Log_double;
+    case Fmt_c: return Log_char;
+    case Fmt_s:
+    case Fmt_json:
+    case Fmt_cstr: return Log_string;
+    case Fmt_p: return Log_pointer;
+    case Fmt_n: return Log_count;
+    case Fmt_percent:
+    case Fmt_unknown: return Log_none;
+    case Fmt_custom: // The data of the pointer can't be captured
+    default: return Log_unsupported;
+    }
+}
+
+// Copies len bytes to the ring, offset bytes after the end of the records, wrapping around its end
+static void log_ring_write(cj_log_ring *const ring, const size_t offset, const void *const data, const size_t len)
+{
+    // The record fits in the free space, so the position is less than twice the size
+    size_t position = ring->first + ring->used + offset;
+    position = (position >= ring->size) ? (position - ring->size) : position;
+    const size_t head = MIN(len, ring->size - position);
+    memcpy(&ring->buffer[position], data, head);
+    memcpy(ring->buffer, (const unsigned char *)data + head, len - head);
+}
+
+// Copies len bytes from the ring, offset bytes after the start of the oldest record
+static void log_ring_read(const cj_log_ring *const ring, const size_t offset, void *const data, const size_t len)
+{
+    size_t position = ring->first + offset;
+    position = (position >= ring->size) ? (position - ring->size) : position;
+    const size_t head = MIN(len, ring->size - position);
+    memcpy(data, &ring->buffer[position], head);
+    memcpy((unsigned char *)data + head, ring->buffer, len - head);
+}
+
+// Appends len bytes to the record being captured, whose length is updated
+// Returns false if they don't fit in the free space of the ring or in the payload
+static bool log_append(cj_log_ring *const ring, size_t *const length, const void *const data, const size_t len)
+{
+    if ((len > (ring->size - ring->used - *length)) || ((*length + len) > (LOG_HEADER_SIZE + LOG_MAX_PAYLOAD))) {
+        return false;
+    }
+    log_ring_write(ring, *length, data, len);
+    *length += len;
+    return true;
+}
+
+// Reads an argument with the promoted type and appends it with the type read by format_conversion
+#define LOG_CAPTURE(ring, length, args, type, promoted)                          \
+    do {                                                                         \
+        const type value = (type)va_arg((args)->list, promoted);                 \
+        if (!log_append((ring), (length), &value, sizeof(value))) {              \
+            return false;                                                        \
+        }                                                                        \
+    } while (0)
+
+// Smallest amount of bytes of the record taken by the arguments of the op, with empty strings
+LIBCJ_FN size_t log_op_size(const cj_fmt_op *const op)
+{
+    size_t size = ((op->width == FMT_FROM_ARGUMENT) ? sizeof(int) : 0) +
+        ((op->precision == FMT_FROM_ARGUMENT) ? sizeof(int) : 0);
+    switch (log_arg(op)) {
+    case Log_char:    return size + sizeof(char);
+    case Log_short:   return size + sizeof(short);
+    case Log_int:     return size + sizeof(int);
+    case Log_long:    return size + sizeof(long);
+    case Log_llong:   return size + sizeof(long long);
+    case Log_double:  return size + sizeof(double);
+    case Log_ldouble: return size + sizeof(long double);
+    case Log_pointer: return size + sizeof(void *);
+    case Log_string:  return size + 1;
+    case Log_count:
+    case Log_none:
+    case Log_unsupported:
+    default: return size;
+    }
+}
+
+// Appends the argument of the conversion to the record being captured
+// Strings are copied up to precision characters, if it isn't negative, and truncated
+// so that the record doesn't exceed the length end, as if the precision was smaller
+static bool log_capture_arg(cj_log_ring *const ring, size_t *const length, struct Fmt_Args *const args, const enum Log_Arg arg, const int precision, const size_t end)
+{
+    switch (arg) {
+    case Log_char:    LOG_CAPTURE(ring, length, args, char, int); break;
+    case Log_short:   LOG_CAPTURE(ring, length, args, short, int); break;
+    case Log_int:     LOG_CAPTURE(ring, length, args, int, int); break;
+    case Log_long:    LOG_CAPTURE(ring, length, args, long, long); break;
+    case Log_llong:   LOG_CAPTURE(ring, length, args, long long, long long); break;
+    case Log_double:  LOG_CAPTURE(ring, length, args, double, double); break;
+    case Log_ldouble: LOG_CAPTURE(ring, length, args, long double, long double); break;
+    case Log_pointer: LOG_CAPTURE(ring, length, args, void *, void *); break;
+    case Log_string: {
+        const char *string = va_arg(args->list, const char *);
+        string = (string != NULL) ? string : "(null)";
+        const int room = (int)(end - *length - 1); // The end leaves room for the null termination
+        const size_t len = string_length(string, ((precision >= 0) && (precision < room)) ? precision : room);
+        return log_append(ring, length, string, len) && log_append(ring, length, "", 1);
+    }
+    case Log_count:
+        (void)va_arg(args->list, int *);
+        break;
+    case Log_none:
+        break;
+    case Log_unsupported:
+    default:
+        return false;
+    }
+    return true;
+}
+
+// Initializes an empty ring of records in a buffer of size bytes, for the compiled formats
+// This function isn't defined by standard-C
+void cj_log_init(cj_log_ring *ring, void *buffer, size_t size, const cj_fmt_compiled *formats, size_t count)
+{
+    ring->buffer = buffer;
+    ring->size = size;
+    ring->first = 0;
+    ring->used = 0;
+    ring->dropped = 0;
+    ring->formats = formats;
+    ring->count = count;
+}
+
+// Captures the arguments of the format with index fmt_id, to be formatted by cj_log_decode
+// This function isn't defined by standard-C
+int cj_log_capture(cj_log_ring *ring, unsigned fmt_id, ...)
+{
+    va_list args;
+    va_start(args, fmt_id);
+    const int result = cj_log_vcapture(ring, fmt_id, args);
+    va_end(args);
+    return result;
+}
+
+// Captures the arguments from variable argument list of the format with index fmt_id
+// The arguments are stored as they are, so no digits are generated. Strings are truncated to
+// keep the arguments within LOG_MAX_PAYLOAD bytes, and the record is dropped if it doesn't fit
+// in the ring, or the format has custom conversions or couldn't be compiled
+// Returns 0 if the record was stored, or -1 otherwise. This function isn't defined by standard-C
+int cj_log_vcapture(cj_log_ring *ring, unsigned fmt_id, va_list args)
+{
+    struct Fmt_Args arguments;
+    const cj_fmt_compiled *const compiled = (fmt_id < ring->count) ? &ring->formats[fmt_id] : NULL;
+    size_t length = LOG_HEADER_SIZE;
+    size_t reserved = 0; // For the arguments of the ops that aren't captured yet
+    bool captured = (compiled != NULL) && (compiled->count >= 0) && ((ring->size - ring->used) >= LOG_HEADER_SIZE);
+    for (int index = 0; captured && (index < compiled->count); index++) {
+        reserved += log_op_size(&compiled->ops[index]);
+    }
+    captured = captured && (reserved <= LOG_MAX_PAYLOAD);
+    va_copy(arguments.list, args);
+    for (int index = 0; captured && (index < compiled->count); index++) {
+        const cj_fmt_op *const op = &compiled->ops[index];
+        reserved -= log_op_size(op);
+        const size_t end = LOG_HEADER_SIZE + LOG_MAX_PAYLOAD - reserved;
+        int precision = op->precision;
+        if (op->width == FMT_FROM_ARGUMENT) {
+            captured = log_capture_arg(ring, &length, &arguments, Log_int, -1, end);
+        }
+        if (captured && (op->precision == FMT_FROM_ARGUMENT)) {
+            precision = va_arg(arguments.list, int);
+            captured = log_append(ring, &length, &precision, sizeof(precision));
+        }
+        captured = captured && log_capture_arg(ring, &length, &arguments, log_arg(op), precision, end);
+    }
+    va_end(arguments.list);
+    if (!captured) {
+        ring->dropped++;
+        return -1;
+    }
+    const uint32_t header[2] = {(uint32_t)fmt_id, (uint32_t)(length - LOG_HEADER_SIZE)};
+    log_ring_write(ring, 0, header, sizeof(header));
+    ring->used += length;
+    return 0;
+}
+
+// Arguments of a captured record, placed as the fields of a row to be formatted by execute_ops
+struct Log_Row {
+    union {
+        max_align_t align;
+        char bytes[LOG_MAX_PAYLOAD];
+    } payload;
+    union {
+        max_align_t align;
+        char bytes[LOG_MAX_ARGS * 2 * sizeof(max_align_t)]; // Enough for each field and its padding
+    } fields;
+    size_t offsets[LOG_MAX_ARGS];
+    size_t count;
+    size_t payload_length;
+    size_t consumed; // Of the payload
+    size_t fields_length;
+    int ignored; // Target of %n
+};
+
+// Places the next argument of the payload in a field of the row, aligned for its type
+// Strings are pointed to in the payload. Returns false if the payload is malformed
+static bool log_decode_arg(struct Log_Row *const row, const enum Log_Arg arg)
+{
+    static const size_t sizes[] = {
+        0, sizeof(char), sizeof(short), sizeof(int), sizeof(long), sizeof(long long),
+        sizeof(double), sizeof(long double), sizeof(void *), sizeof(char *), sizeof(int *), 0
+    };
+    static const size_t alignments[] = {
+        1, _Alignof(char), _Alignof(short), _Alignof(int), _Alignof(long), _Alignof(long long),
+        _Alignof(double), _Alignof(long double), _Alignof(void *), _Alignof(char *), _Alignof(int *), 1
+    };
+    if ((arg == Log_none) || (arg == Log_unsupported)) {
+        return arg == Log_none;
+    }
+    const size_t offset = (row->fields_length + alignments[arg] - 1) & ~(alignments[arg] - 1);
+    char *const field = &row->fields.bytes[offset];
+    if (arg == Log_string) {
+        const char *const string = &row->payload.bytes[row->consumed];
+        const char *const end = memchr(string, '\0', row->payload_length - row->consumed);
+        if (end == NULL) {
+            return false;
+        }
+        memcpy(field, &string, sizeof(string));
+        row->consumed += (size_t)(end - string) + 1;
+    } else if (arg == Log_count) {
+        int *const ignored = &row->ignored;
+        memcpy(field, &ignored, sizeof(ignored));
+    } else {
+        if (sizes[arg] > (row->payload_length - row->consumed)) {
+            return false;
+        }
+        memcpy(field, &row->payload.bytes[row->consumed], sizes[arg]);
+        row->consumed += sizes[arg];
+    }
+    row->offsets[row->count++] = offset;
+    row->fields_length = offset + sizes[arg];
+    return true;
+}
+
+// Formats the records of the ring in the order they were captured, passing the output in chunks
+// to the callback, and removes them from the ring. The records can also be decoded by another
+// process, with the same formats and a copy of the buffer, first and used
+// Return the amount of characters written, or -1 if a record is malformed (it is kept in the ring)
+// This function isn't defined by standard-C
+int cj_log_decode(cj_log_ring *ring, cj_print_callback cb, void *ctx)
+{
+    struct Callback_Context context;
+    struct Sink sink;
+    struct Log_Row row;
+    int written = 0;
+    if (cb == NULL) {
+        return -1;
+    }
+    callback_sink(&sink, &context, cb, ctx);
+    while (ring->used >= LOG_HEADER_SIZE) {
+        uint32_t header[2];
+        log_ring_read(ring, 0, header, sizeof(header));
+        const cj_fmt_compiled *const compiled = (header[0] < ring->count) ? &ring->formats[header[0]] : NULL;
+        bool valid = (compiled != NULL) && (compiled->count >= 0) && (header[1] <= LOG_MAX_PAYLOAD) &&
+            (header[1] <= (ring->used - LOG_HEADER_SIZE));
+        if (valid) {
+            row.payload_length = header[1];
+            row.consumed = 0;
+            row.fields_length = 0;
+            row.count = 0;
+            log_ring_read(ring, LOG_HEADER_SIZE, row.payload.bytes, row.payload_length);
+        }
+        for (int index = 0; valid && (index < compiled->count); index++) {
+            const cj_fmt_op *const op = &compiled->ops[index];
+            valid = ((op->width != FMT_FROM_ARGUMENT) || log_decode_arg(&row, Log_int)) &&
+                ((op->precision != FMT_FROM_ARGUMENT) || log_decode_arg(&row, Log_int)) &&
+                log_decode_arg(&row, log_arg(op));
+        }
+        if (!valid || (row.consumed != row.payload_length)) {
+            written = -1;
+            break;
+        }
+        struct Fmt_Args arguments;
+        arguments.row = row.fields.bytes;
+        arguments.offsets = row.offsets;
+        arguments.field = 0;
+        arguments.store_counts = true;
+        written += execute_ops(&sink, compiled, &arguments, written);
+        const size_t length = LOG_HEADER_SIZE + row.payload_length;
+        ring->first = ((ring->size - ring->first) > length) ? (ring->first + length) : (length - (ring->size - ring->first));
+        ring->used -= length;
+    }
+    callback_flush(&sink);
+    return written;
+}
+
+#ifdef LIBCJ_POSIX
+// Writes all the buffers, retrying after partial writes and interruptions
+static bool write_all(const int fd, struct iovec *iov, int count)
+{
+    while (count > 0) {
+        const ssize_t result = writev(fd, iov, count);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        size_t written = (size_t)result;
+        for (; (count > 0) && (written >= iov->iov_len); iov++, count--) {
+            written -= iov->iov_len;
+        }
+        if (count > 0) {
+            iov->iov_base = (char *)iov->iov_base + written;
+            iov->iov_len -= written;
+        }
+    }
+    return true;
+}
+
+// Writes the buffered characters followed by str (that may be empty) in a single system call
+static bool file_write(cj_file *const file, const char *const str, const size_t len)
+{
+    struct iovec iov[2];
+    int count = 0;
+    if (file->length > 0) {
+        iov[count].iov_base = file->buffer;
+        iov[count].iov_len = file->length;
+        count++;
+    }
+    if (len > 0) {
+        iov[count].iov_base = (void *)(uintptr_t)str;
+        iov[count].iov_len = len;
+        count++;
+    }
+    file->length = 0;
+    if (!write_all(file->fd, iov, count)) {
+        file->error = 1;
+    }
+    return file->error == 0;
+}
+
+static void file_sink(struct Sink *const sink, cj_file *const file);
+
+static bool file_sink_overflow(struct Sink *const sink)
+{
+    cj_file *const file = sink->context;
+    file->length = (size_t)(sink->cursor - file->buffer);
+    file_write(file, NULL, 0);
+    file_sink(sink, file);
+    return file->error == 0;
+}
+
+// Strings that doesn't fit in the buffer are written by reference, together with the buffer
+static bool file_sink_write_through(struct Sink *const sink, const char *const str, const size_t len)
+{
+    cj_file *const file = sink->context;
+    file->length = (size_t)(sink->cursor - file->buffer);
+    file_write(file, str, len);
+    file_sink(sink, file);
+    return true;
+}
+
+// Sink that appends to the buffer of the file
+static void file_sink(struct Sink *const sink, cj_file *const file)
+{
+    sink->cursor = &file->buffer[file->length];
+    sink->room = file->size - file->length - 1; // The null termination isn't written to the file
+    sink->overflow = file_sink_overflow;
+    sink->write_through = file_sink_write_through;
+    sink->fill_through = NULL;
+    sink->context = file;
+}
+
+// Initializes a buffered writer over the file descriptor fd, with a buffer of size bytes (at least 2)
+// This function isn't defined by standard-C
+void cj_file_init(cj_file *file, int fd, char *buffer, size_t size)
+{
+    file->fd = fd;
+    file->buffer = buffer;
+    file->size = size;
+    file->length = 0;
+    file->error = 0;
+}
+
+// Writes the buffered characters to the file descriptor. This function isn't defined by standard-C
+// Returns 0 on success, or -1 if any write to the file failed since it was initialized
+int cj_file_flush(cj_file *file)
+{
+    if (file->length > 0) {
+        file_write(file, NULL, 0);
+    }
+    return (file->error != 0) ? -1 : 0;
+}
+
+// Write formatted data to a buffered file. This function isn't defined by standard-C
+int cj_dprintf(cj_file *file, const char *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    const int written = cj_vdprintf(file, fmt, args);
+    va_end(args);
+    return written;
+}
+
+// Write formatted data from variable argument list to a buffered file. This function isn't defined by standard-C
+// The output stays in the buffer until it is full or cj_file_flush is called
+int cj_vdprintf(cj_file *file, const char *fmt, va_list args)
+{
+    struct Sink sink;
+    if ((file == NULL) || (file->size < 2)) {
+        return -1;
+    }
+    file_sink(&sink, file);
+    const int written = __vsnprintf(&sink, fmt, args);
+    file->length = (size_t)(sink.cursor - file->buffer);
+    return (file->error != 0) ? -1 : written;
+}
+#endif // LIBCJ_POSIX
+
+// Initial capacity of the string builders
+#define STRING_BUILDER_MIN_CAPACITY 64
+
+// Makes room in the string builder, doubling its capacity
+static bool sb_grow(cj_sb *const sb, const size_t length)
+{
+    if ((sb->error != 0) || (sb->allocator == NULL)) {
+        sb->error = 1;
+        return false;
+    }
+    const size_t capacity = MAX(2 * sb->capacity, STRING_BUILDER_MIN_CAPACITY);
+    char *const str = sb->allocator(sb->ctx, sb->str, capacity);
+    if ((str == NULL) || (capacity <= sb->capacity)) {
+        sb->error = 1;
+        return false;
+    }
+    sb->str = str;
+    sb->capacity = capacity;
+    sb->length = length;
+    return true;
+}
+
+static void sb_sink(struct Sink *const sink, cj_sb *const sb);
+
+// Grows the string builder, and the formatting is resumed where it stopped
+static bool sb_sink_overflow(struct Sink *const sink)
+{
+    cj_sb *const sb = sink->context;
+    const size_t length = (sink->cursor != NULL) ? (size_t)(sink->cursor - sb->str) : sb->length;
+    if (!sb_grow(sb, length)) {
+        return false;
+    }
+    sb_sink(sink, sb);
+    return true;
+}
+
+// Sink that appends to the spare capacity of the string builder
+static void sb_sink(struct Sink *const sink, cj_sb *const sb)
+{
+    sink->cursor = (sb->str != NULL) ? &sb->str[sb->length] : NULL;
+    sink->room = (sb->str != NULL) ? (sb->capacity - sb->length - 1) : 0;
+    sink->overflow = sb_sink_overflow;
+    sink->write_through = NULL;
+    sink->fill_through = NULL;
+    sink->context = sb;
+}
+
+// Initializes an empty string builder, whose memory is managed by allocator
+// This function isn't defined by standard-C
+void cj_sb_init(cj_sb *sb, cj_sb_allocator allocator, void *ctx)
+{
+    sb->str = NULL;
+    sb->length = 0;
+    sb->capacity = 0;
+    sb->allocator = allocator;
+    sb->ctx = ctx;
+    sb->error = 0;
+}
+
+// Releases the memory of the string builder, that becomes empty. This function isn't defined by standard-C
+void cj_sb_free(cj_sb *sb)
+{
+    if ((sb->str != NULL) && (sb->allocator != NULL)) {
+        sb->allocator(sb->ctx, sb->str, 0);
+    }
+    cj_sb_init(sb, sb->allocator, sb->ctx);
+}
+
+// Appends len characters of str to the string builder. This function isn't defined by standard-C
+// Returns the amount of characters appended, or -1 if the memory couldn't be allocated
+int cj_sb_append(cj_sb *sb, const char *str, size_t len)
+{
+    struct Sink sink;
+    sb_sink(&sink, sb);
+    sink_append(&sink, str, len);
+    sb->length = (sink.cursor != NULL) ? (size_t)(sink.cursor - sb->str) : sb->length;
+    sink_terminate(&sink);
+    return (sb->error != 0) ? -1 : (int)len;
+}
+
+// Appends the character c to the string builder. This function isn't defined by standard-C
+int cj_sb_putc(cj_sb *sb, char c)
+{
+    return cj_sb_append(sb, &c, 1);
+}
+
+// Appends formatted data to the string builder. This function isn't defined by standard-C
+int cj_sb_appendf(cj_sb *sb, const char *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    const int written = cj_sb_vappendf(sb, fmt, args);
+    va_end(args);
+    return written;
 }
 
-// Helper macros used to simplify code in __vsnprintf
-#define PRINTF_HANDLE_INT(base)                                                                            \
-    do {                                                                                                   \
-        switch (modifier) {                                                                                \
-        case Modifier_char:                                                                                \
-            written += int_to_str(buf, sz, width, precision, flags, base, true, (char)va_arg(args, int));  \
-            break;                                                                                         \
-        case Modifier_short:                                                                               \
-            written += int_to_str(buf, sz, width, precision, flags, base, true, (short)va_arg(args, int)); \
-            break;                                                                                         \
-        case Modifier_long:                                                                                \
-            written += int_to_str(buf, sz, width, precision, flags, base, true, va_arg(args, long));       \
-            break;                                                                                         \
-        case Modifier_llong:                                                                               \
-            written += int_to_str(buf, sz, width, precision, flags, base, true, va_arg(args, long long));  \
-            break;                                                                                         \
-        case Modifier_None:                                                                                \
-        case Modifier_ldouble:                                                                             \
-        default:                                                                                           \
-            written += int_to_str(buf, sz, width, precision, flags, base, true, va_arg(args, int));        \
-            break;                                                                                         \
-        }                                                                                                  \
-    } while (0)
+// Appends formatted data from variable argument list to the string builder
+// The output is formatted in the spare capacity, and when it runs out the builder grows
+// geometrically and the formatting continues from that point. This function isn't defined by standard-C
+int cj_sb_vappendf(cj_sb *sb, const char *fmt, va_list args)
+{
+    struct Sink sink;
+    sb_sink(&sink, sb);
+    const int written = __vsnprintf(&sink, fmt, args);
+    sb->length = (sink.cursor != NULL) ? (size_t)(sink.cursor - sb->str) : sb->length;
+    return (sb->error != 0) ? -1 : written;
+}
 
-#define PRINTF_HANDLE_UINT(base)                                                                                              \
-    do {                                                                                                                      \
-        flags = flags & (enum Fmt_Flags)~Flag_Plus; /* This flag isn't supported for unsigned numbers */                      \
-        switch (modifier) {                                                                                                   \
-        case Modifier_char:                                                                                                   \
-            written += int_to_str(buf, sz, width, precision, flags, base, false, (unsigned char)va_arg(args, unsigned int));  \
-            break;                                                                                                            \
-        case Modifier_short:                                                                                                  \
-            written += int_to_str(buf, sz, width, precision, flags, base, false, (unsigned short)va_arg(args, unsigned int)); \
-            break;                                                                                                            \
-        case Modifier_long:                                                                                                   \
-            written += int_to_str(buf, sz, width, precision, flags, base, false, (intmax_t)va_arg(args, unsigned long));      \
-            break;                                                                                                            \
-        case Modifier_llong:                                                                                                  \
-            written += int_to_str(buf, sz, width, precision, flags, base, false, (intmax_t)va_arg(args, unsigned long long)); \
-            break;                                                                                                            \
-        case Modifier_None:                                                                                                   \
-        case Modifier_ldouble:                                                                                                \
-        default:                                                                                                              \
-            written += int_to_str(buf, sz, width, precision, flags, base, false, va_arg(args, unsigned int));                 \
-            break;                                                                                                            \
-        }                                                                                                                     \
-    } while (0)
+// Amount and size of the thread-local slots of tprintf, that are reused in turns
+#define TPRINTF_SLOTS 8
+#define TPRINTF_SLOT_SIZE 512
+// Minimum size of the chunks of the arena where longer outputs spill
+#define TPRINTF_CHUNK_SIZE 16384
 
-// TODO: long double is not currently supported
-#define PRINTF_HANDLE_FLOAT(base, special_flag)                                                                                   \
-    do {                                                                                                                          \
-        switch (modifier) {                                                                                                       \
-        case Modifier_ldouble:                                                                                                    \
-            written += double_to_str(buf, sz, width, precision, (flags | special_flag), base, (double)va_arg(args, long double)); \
-            break;                                                                                                                \
-        case Modifier_None:                                                                                                       \
-        case Modifier_char:                                                                                                       \
-        case Modifier_short:                                                                                                      \
-        case Modifier_long:                                                                                                       \
-        case Modifier_llong:                                                                                                      \
-        default:                                                                                                                  \
-            written += double_to_str(buf, sz, width, precision, (flags | special_flag), base, va_arg(args, double));              \
-            break;                                                                                                                \
-        }                                                                                                                         \
-    } while (0)
+// Chunk of the spill arena of tprintf, the newest one is the head of the list
+struct Tprintf_Chunk {
+    struct Tprintf_Chunk *next;
+    cj_sb_allocator allocator; // The one that allocated the chunk, that releases it
+    void *ctx;
+    size_t size;
+    size_t used;
+    char data[];
+};
+
+static cj_sb_allocator tprintf_allocator;
+static void *tprintf_allocator_ctx;
+static THREAD_LOCAL char tprintf_slots[TPRINTF_SLOTS][TPRINTF_SLOT_SIZE];
+static THREAD_LOCAL unsigned tprintf_next_slot;
+// Allocated on the first output that doesn't fit in a slot
+static THREAD_LOCAL struct Tprintf_Chunk *tprintf_arena;
 
-static int __vsnprintf(char **buf, size_t *const sz, const char *fmt, va_list args)
+// Sets the allocator of the spill arenas of tprintf, with the semantics of realloc (shared by all threads)
+// Without an allocator, the outputs that don't fit in a slot take all of them and are truncated
+// It must be set before other threads use tprintf, each chunk is released by the allocator of its own
+// This function isn't defined by standard-C
+void cj_tprintf_allocator(cj_sb_allocator allocator, void *ctx)
 {
-    enum Fmt_Flags flags;
-    enum Length_Modifier modifier;
-    bool uppercase;
-    int written = 0;
-    const char *cursor = fmt;
-    if (fmt == NULL) {
-        return -1;
+    tprintf_allocator = allocator;
+    tprintf_allocator_ctx = ctx;
+}
+
+// Checks if the output being formatted is at the free space of the head chunk of the arena
+static bool tprintf_in_arena(const char *const output)
+{
+    return (tprintf_arena != NULL) && (output == &tprintf_arena->data[tprintf_arena->used]);
+}
+
+// Moves the output of tprintf that doesn't fit to the free space of the arena, adding a larger chunk
+// to it when needed, and to the start of the slots (using all of them) when it can't be allocated
+// The formatting is resumed where it stopped, after copying what was already written
+static bool tprintf_overflow(struct Sink *const sink)
+{
+    char **const output = sink->context;
+    const size_t length = (size_t)(sink->cursor - *output);
+    const bool in_arena = tprintf_in_arena(*output);
+    struct Tprintf_Chunk *chunk = tprintf_arena;
+    if (!in_arena && (length >= TPRINTF_SLOT_SIZE)) { // Longer than a slot, so it already fills all of them
+        return false;
     }
-    while (*cursor != '\0') {
-        enum Fmt_Specifier specifier = Fmt_unknown;
-        int width = -1, precision = -1;
-        if (*cursor == '%') {
-            va_list copied_args;
-            va_copy(copied_args, args);
-            int parsed_chars = 1; // Start with one character parsed ('%')
-            // snprintf format specifier follows this pattern:
-            // %[flags][width][.precision][length]specifier
-            // https://cplusplus.com/reference/cstdio/printf/
-            parsed_chars += parse_fmt_flags((cursor+parsed_chars), &flags);
-            parsed_chars += parse_width_precision((cursor+parsed_chars), copied_args, &width, &precision);
-            parsed_chars += parse_fmt_specifier((cursor+parsed_chars), &specifier, &modifier, &uppercase);
-            // If the format specifier was fully parsed, update the cursor position and args
-            if (specifier != Fmt_unknown) {
-                args = copied_args;
-                cursor += parsed_chars;
-            }
-            if (uppercase) {
-                flags |= Flag_Upper;
-            }
+    if ((chunk == NULL) || in_arena || ((chunk->size - chunk->used) <= (length + 1))) {
+        const size_t chunk_size = MAX(TPRINTF_CHUNK_SIZE, (chunk != NULL) ? 2 * chunk->size : 0);
+        chunk = (tprintf_allocator != NULL) ?
+            tprintf_allocator(tprintf_allocator_ctx, NULL, sizeof(struct Tprintf_Chunk) + chunk_size) : NULL;
+        if ((chunk == NULL) && in_arena) {
+            return false;
         }
-        switch (specifier) {
-        case Fmt_d:
-        case Fmt_i: // Signed integer
-            PRINTF_HANDLE_INT(10);
-            break;
-        case Fmt_u: // Unsigned integer
-            PRINTF_HANDLE_UINT(10);
-            break;
-        case Fmt_o: // Unsigned integer in octal form
-            PRINTF_HANDLE_UINT(8);
-            break;
-        case Fmt_x: // Unsigned integer in hexadecimal form
-            PRINTF_HANDLE_UINT(16);
-            break;
-        case Fmt_f: // Decimal floating point
-            PRINTF_HANDLE_FLOAT(10, 0);
-            break;
-        case Fmt_e: // Decimal floating point in exponent form
-            PRINTF_HANDLE_FLOAT(10, Flag_Exp);
-            break;
-        case Fmt_g: // Decimal floating point in shortest form
-            PRINTF_HANDLE_FLOAT(10, Flag_Short);
-            break;
-        case Fmt_a: // Decimal floating point in hexadecimal form
-            PRINTF_HANDLE_FLOAT(16, Flag_Exp);
-            break;
-        case Fmt_c: // Character
-            PUTCHAR((char)va_arg(args, int));
-            written++;
-            break;
-        case Fmt_s: // String
-            written += put_string(buf, sz, width, precision, (flags & Flag_Minus), va_arg(args, char *));
-            break;
-        case Fmt_p: { // Pointer
-            const void *ptr = va_arg(args, void *);
-            if (ptr == NULL) {
-                written += put_string(buf, sz, width, precision, (flags & Flag_Minus), "(nil)");
-            } else {
-                written += int_to_str(buf, sz, width, precision, (flags | Flag_Hash), 16, false, (intmax_t)ptr);
-            }
-        } break;
-        case Fmt_n: { // Return the number of characters written so far
-            // TODO: Length modifiers are not implemented for %n
-            int *ptr = va_arg(args, int *);
-            *ptr = written;
-        } break;
-        case Fmt_percent:
-            PUTCHAR('%');
-            written++;
-            break;
-        case Fmt_unknown:
-            PUTCHAR(*cursor);
-            cursor++;
-            written++;
-            break;
+        if (chunk == NULL) { // Truncated to the size of all the slots
+            memmove(tprintf_slots[0], *output, length);
+            *output = tprintf_slots[0];
+            sink->cursor = &tprintf_slots[0][length];
+            sink->room = sizeof(tprintf_slots) - length - 1;
+            return true;
         }
+        chunk->next = tprintf_arena;
+        chunk->allocator = tprintf_allocator;
+        chunk->ctx = tprintf_allocator_ctx;
+        chunk->size = chunk_size;
+        chunk->used = 0;
+        tprintf_arena = chunk;
+    }
+    char *const destination = &chunk->data[chunk->used];
+    memcpy(destination, *output, length);
+    *output = destination;
+    sink->cursor = &destination[length];
+    sink->room = chunk->size - chunk->used - length - 1;
+    return true;
+}
+
+// Releases the outputs of tprintf of the calling thread that spilled to its arena, which keeps
+// its newest chunk to be reused. This function isn't defined by standard-C
+void cj_tprintf_reset(void)
+{
+    if (tprintf_arena == NULL) {
+        return;
     }
-    // null termination
-    if ((sz == NULL) || (*sz > 0)) {
-        **buf = '\0';
+    struct Tprintf_Chunk *chunk = tprintf_arena->next;
+    while (chunk != NULL) {
+        struct Tprintf_Chunk *const next = chunk->next;
+        chunk->allocator(chunk->ctx, chunk, 0);
+        chunk = next;
+    }
+    tprintf_arena->next = NULL;
+    tprintf_arena->used = 0;
+}
+
+// Releases all the memory of the spill arena of the calling thread, that should be done before
+// the thread exits. This function isn't defined by standard-C
+void cj_tprintf_free(void)
+{
+    cj_tprintf_reset();
+    if (tprintf_arena != NULL) {
+        tprintf_arena->allocator(tprintf_arena->ctx, tprintf_arena, 0);
+        tprintf_arena = NULL;
     }
-    return written;
 }
 
 // Temporary buffer print function
+// The output is written to the next of the thread-local slots, so that the last TPRINTF_SLOTS
+// outputs are valid at the same time. Longer outputs are moved to the arena of the thread
+// when they overflow the slot, and are valid until cj_tprintf_reset is called
 char *tprintf(char *fmt, ...) {
-    static THREAD_LOCAL char buffer[4096];
+    struct Sink sink;
+    char *output = tprintf_slots[tprintf_next_slot];
+    sink_buffer(&sink, output, &(size_t){TPRINTF_SLOT_SIZE});
+    sink.overflow = tprintf_overflow;
+    sink.context = &output;
+    output[0] = '\0';
     va_list args;
     va_start(args, fmt);
-    const int written = vsnprintf(buffer, sizeof(buffer), fmt, args);
+    __vsnprintf(&sink, fmt, args);
     va_end(args);
-    if (written >= 0) {
-        return buffer;
+    if (tprintf_in_arena(output)) {
+        tprintf_arena->used += (size_t)(sink.cursor - output) + 1;
+    } else {
+        tprintf_next_slot = (tprintf_next_slot + 1) % TPRINTF_SLOTS;
     }
-    return NULL;
+    return output;
 }
 
 //------------------------------------------------------------------------------
@@ -1337,18 +5343,25 @@ long long atoll(const char *str)
         if (base == 0) { \
             base = 10; \
         } \
-        for (; *str != '\0'; str++) { \
-            int digit = 0; \
-            if (isdigit(*str)) { \
-                digit = *str - '0'; \
-            } else if ((base > 10) && isalpha(*str)) { \
-                digit = tolower(*str) - 'a' + 10; \
+        const char *digits = str; \
+        while (DIGIT_VALUE(*str) < base) { \
+            str++; \
+        } \
+        if (pow2_base_shift(base) != 0) { \
+            /* Power of two bases are converted with shifts, and overflow is detected up front */ \
+            bool overflow; \
+            const uintmax_t magnitude = base_digits_to_uint(digits, (int)(str - digits), base, &overflow); \
+            const bool is_signed = (min) < (zero); \
+            const uintmax_t limit = (uintmax_t)(max) + ((negative && is_signed) ? 1 : 0); \
+            if (overflow || (magnitude > limit)) { \
+                value = (negative && is_signed) ? (min) : (max); \
             } else { \
-                break; \
-            } \
-            if (digit >= base) { \
-                break; \
+                value = (type)(negative ? (0 - magnitude) : magnitude); \
             } \
+            digits = str; \
+        } \
+        for (; digits < str; digits++) { \
+            const int digit = DIGIT_VALUE(*digits); \
             if (negative) { \
                 if (value >= (min) / (type)base) { \
                     value = (type)base * (value) - (type)digit; \
@@ -1384,81 +5397,480 @@ double atof(const char *str)
 }
 
 // Convert string to floating point number
-#define CREATE_STRTOF_FN(name, type, zero, max) \
-    type name(const char *str, char **endptr) \
+// The result is correctly rounded, no matter how many digits the string has
+#define CREATE_STRTOF_FN(name, type, zero, convert)                   \
+    type name(const char *str, char **endptr)                         \
+    {                                                                 \
+        struct Decimal dec;                                           \
+        SKIP_WHITESPACES(str);                                        \
+        const int parsed_chars = str_to_decimal(str, NULL, &dec);     \
+        if (endptr != NULL) {                                         \
+            *endptr = (char *)str + parsed_chars;                     \
+        }                                                             \
+        if (parsed_chars == 0) {                                      \
+            return zero;                                              \
+        }                                                             \
+        return convert(&dec);                                         \
+    }
+
+// Some sort of generics in C using the preprocessor
+CREATE_STRTOF_FN(strtof, float, 0.0f, decimal_to_float)
+CREATE_STRTOF_FN(strtod, double, 0.0, decimal_to_double)
+CREATE_STRTOF_FN(strtold, long double, 0.0L, decimal_to_long_double)
+
+// Convert integers to decimal strings, returning a pointer to the null terminator
+// The buffer must have room for 21 characters
+char *cj_i64toa(const int64_t value, char *str)
+{
+    if (value < 0) {
+        *str++ = '-';
+        return cj_u64toa(0 - (uint64_t)value, str);
+    }
+    return cj_u64toa((uint64_t)value, str);
+}
+
+char *cj_u64toa(const uint64_t value, char *str)
+{
+    const int length = decimal_length(value);
+    write_decimal(str, value, length);
+    str[length] = '\0';
+    return &str[length];
+}
+
+// Convert integer to hexadecimal string (without prefix), returning a pointer to the null terminator
+// The buffer must have room for 17 characters
+char *cj_u64toa_hex(const uint64_t value, char *str, const int uppercase)
+{
+    const int shift = 4;
+    const int length = pow2_length(value, shift);
+    write_pow2(str, value, length, shift, uppercase);
+    str[length] = '\0';
+    return &str[length];
+}
+
+// Convert double to the shortest decimal string that converts back to the same value,
+// returning a pointer to the null terminator. The buffer must have room for 25 characters
+// Like %.17g, the exponent form is only used for exponents less than -4 or greater than 16
+char *cj_dtoa_shortest(const double value, char *str)
+{
+    struct Binary_Float binary;
+    double_to_binary(value, &binary);
+    if (binary.negative) {
+        *str++ = '-';
+    }
+    if (binary.kind != Float_Finite) {
+        memcpy(str, (binary.kind == Float_Infinite) ? "inf" : "nan", 4);
+        return &str[3];
+    }
+    if (binary.mantissa == 0) {
+        memcpy(str, "0", 2);
+        return &str[1];
+    }
+    int exponent;
+    const uint64_t mantissa = double_to_shortest(&binary, &exponent);
+    const int length = decimal_length(mantissa);
+    // Decimal exponent of the first digit
+    const int first = exponent + length - 1;
+    if ((first < -4) || (first > 16)) {
+        write_decimal(&str[1], mantissa, length);
+        str[0] = str[1];
+        if (length > 1) {
+            str[1] = '.';
+            str += length + 1;
+        } else {
+            str++;
+        }
+        *str++ = 'e';
+        *str++ = (first < 0) ? '-' : '+';
+        const int digits = MAX(decimal_length((uint64_t)ABS(first)), 2);
+        write_decimal(str, (uint64_t)ABS(first), digits);
+        str += digits;
+    } else if (exponent >= 0) { // Integer
+        write_decimal(str, mantissa, length);
+        memset(&str[length], '0', (size_t)exponent);
+        str += length + exponent;
+    } else if (first >= 0) { // Decimal point between the digits
+        write_decimal(str, mantissa, length);
+        memmove(&str[first+2], &str[first+1], (size_t)(length - first - 1));
+        str[first+1] = '.';
+        str += length + 1;
+    } else { // Leading zeros
+        const int zeros = -first - 1;
+        memcpy(str, "0.0000", (size_t)(zeros + 2));
+        write_decimal(&str[zeros+2], mantissa, length);
+        str += zeros + 2 + length;
+    }
+    *str = '\0';
+    return str;
+}
+
+// Maximum length of a value written by cj_format_*_array, with its sign and separator
+#define FORMAT_ARRAY_MAX_LENGTH 22
+
+// Writes the decimal digits of value, eight at a time, returning the end of the string
+// It may write up to 7 characters after the end, so there must be room for 20 characters
+LIBCJ_FN char *put_decimal_swar(char *str, uint64_t value)
+{
+    if (value >= 10000000000000000ULL) { // 10^16, the top digits are written first
+        const int length = decimal_length(value / 10000000000000000ULL);
+        write_decimal(str, value / 10000000000000000ULL, length);
+        str += length;
+        value %= 10000000000000000ULL;
+        store_word(str, eight_digits_to_word((uint32_t)(value / 100000000)));
+        str += 8;
+    } else if (value >= 100000000) {
+        const uint64_t high = value / 100000000;
+        const int length = decimal_length(high);
+        store_word(str, eight_digits_to_word((uint32_t)high) >> (8 * (8 - length)));
+        str += length;
+    } else { // The leading zeros are in the lowest bytes of the word
+        const int length = decimal_length(value);
+        store_word(str, eight_digits_to_word((uint32_t)value) >> (8 * (8 - length)));
+        return str + length;
+    }
+    store_word(str, eight_digits_to_word((uint32_t)(value % 100000000)));
+    return str + 8;
+}
+
+// Writes a value of cj_format_*_array to str, preceded by the separator unless it is the first one
+// Returns the end of the string
+LIBCJ_FN char *put_array_value(char *str, const bool negative, const uint64_t magnitude, const char separator, const bool first)
+{
+    if (!first) {
+        *str++ = separator;
+    }
+    if (negative) {
+        *str++ = '-';
+    }
+    return put_decimal_swar(str, magnitude);
+}
+
+// Writes the values of an integer array separated by 'separator' to sized buffer
+// While there is enough room, the digits are written straight to the buffer, eight at a time. The last
+// values are written to a local buffer to be truncated, and the ones that don't fit at all are only counted
+// Return the amount of characters that would have been written if we had enough size
+#define CREATE_FORMAT_ARRAY_FN(name, type, is_signed) \
+    size_t name(const type *values, size_t count, char separator, char *out, size_t cap) \
     { \
-        const int base = 10; \
-        bool dotted = false; \
-        int exponent = 0; \
-        bool negative = false; \
-        type value = zero; \
-        SKIP_WHITESPACES(str); \
-        if ((*str == '+') || (*str == '-')) { \
-            negative = *str == '-'; \
-            str++; \
-        } \
-        for (; *str != '\0'; str++) { \
-            if (isdigit(*str)) { \
-                const int digit = *str - '0'; \
-                if (value <= max / (type)base) { \
-                    value = value * (type)base + (type)digit; \
-                } else { \
-                    exponent++; \
-                } \
-                if (dotted) { \
-                    exponent--; \
-                } \
-            } else if (*str == '.') { \
-                if (dotted) { \
-                    break; \
-                } \
-                dotted = true; \
+        size_t written = 0; \
+        for (size_t i = 0; i < count; i++) { \
+            const bool negative = (is_signed) && ((int64_t)values[i] < 0); \
+            const uint64_t magnitude = negative ? (0 - (uint64_t)values[i]) : (uint64_t)values[i]; \
+            if ((cap > written) && ((cap - written) > FORMAT_ARRAY_MAX_LENGTH)) { \
+                written += (size_t)(put_array_value(&out[written], negative, magnitude, separator, i == 0) - &out[written]); \
+            } else if (cap > (written + 1)) { \
+                char str[FORMAT_ARRAY_MAX_LENGTH + 8]; \
+                const size_t length = (size_t)(put_array_value(str, negative, magnitude, separator, i == 0) - str); \
+                memcpy(&out[written], str, MIN(length, cap - 1 - written)); \
+                written += length; \
             } else { \
-                break; \
-            } \
-        } \
-        if (tolower(*str) == 'e') { \
-            char *endint = NULL; \
-            const int exp = strtoi((str+1), &endint, 10); \
-            if ((endint != NULL) && ((endint-str) > 1)) { \
-                str = endint; \
-                if (exponent > 0) { \
-                    exponent = ((INT_MAX - exponent) < exp) ? INT_MAX : (exponent + exp); \
-                } else { \
-                    exponent = (exp < (INT_MIN - exponent)) ? INT_MIN : (exponent + exp); \
-                } \
+                written += ((i > 0) ? 1U : 0U) + (negative ? 1U : 0U) + (size_t)decimal_length(magnitude); \
             } \
         } \
-        if (endptr != NULL) { \
-            *endptr = (char *)str; \
-        } \
-        if (value == zero) { \
-            return value; \
+        if (cap > 0) { \
+            out[MIN(written, cap - 1)] = '\0'; \
         } \
-        if (negative) { \
-            value = -value; \
-        } \
-        if (exponent < 0) { \
-            while (exponent++ != 0) { \
-                value /= (type)base; \
-            } \
-        } else { \
-            while (exponent-- != 0) { \
-                if (value < -(type)max/(type)base) { \
-                    return -HUGE_VAL; \
-                } else if ((type)max/(type)base < value) { \
-                    return HUGE_VAL; \
-                } \
-                value *= (type)base; \
-            } \
-        } \
-        return value; \
+        return written; \
     }
 
-// Some sort of generics in C using the preprocessor
-CREATE_STRTOF_FN(strtof, float, 0.0f, FLT_MAX)
-CREATE_STRTOF_FN(strtod, double, 0.0, DBL_MAX)
-CREATE_STRTOF_FN(strtold, long double, 0.0L, LDBL_MAX)
+CREATE_FORMAT_ARRAY_FN(cj_format_i64_array, int64_t, true)
+CREATE_FORMAT_ARRAY_FN(cj_format_u64_array, uint64_t, false)
+CREATE_FORMAT_ARRAY_FN(cj_format_i32_array, int32_t, true)
+CREATE_FORMAT_ARRAY_FN(cj_format_u32_array, uint32_t, false)
+
+// Amount of fields converted at once by cj_parse_f64_array
+#define PARSE_BATCH_SIZE 64
+
+// Convert a column of fields separated by 'separator' to doubles
+// Each field is parsed as strtod would do it, and gets exactly the same value
+// Returns the amount of values stored
+size_t cj_parse_f64_array(const char *str, size_t sz, char separator, double *values, size_t count)
+{
+    struct Decimal decs[PARSE_BATCH_SIZE];
+    size_t parsed = 0;
+    size_t offset = 0;
+    while ((parsed < count) && (offset < sz)) {
+        size_t batch = 0;
+        for (; (batch < PARSE_BATCH_SIZE) && ((parsed + batch) < count) && (offset < sz); batch++) {
+            // Find the end of the field, 8 bytes at a time
+            size_t field_end = offset;
+            for (; (sz - field_end) >= 8; field_end += 8) {
+                const int index = word_find_byte(load_word(&str[field_end]), separator);
+                if (index < 8) {
+                    field_end += (size_t)index;
+                    break;
+                }
+            }
+            while ((field_end < sz) && (str[field_end] != separator)) {
+                field_end++;
+            }
+            const char *field = &str[offset];
+            const char *const end = &str[field_end];
+            while ((field < end) && isspace(*field)) {
+                field++;
+            }
+            str_to_decimal(field, end, &decs[batch]);
+            offset = field_end + 1;
+        }
+        decimals_to_doubles(decs, batch, &values[parsed]);
+        parsed += batch;
+    }
+    return parsed;
+}
+
+// Decode pairs of hexadecimal digits into bytes
+// Decoding stops at the first pair containing a character that isn't an hexadecimal digit
+// Returns the amount of bytes written to dst
+size_t cj_hex_decode(void *dst, const char *hex, size_t len)
+{
+    uint8_t *dst8 = (uint8_t *)dst;
+    size_t written = 0;
+    // Decode 8 digits at a time
+    for (; (len - 2*written) >= 8; written += 4) {
+        const uint64_t word = load_word(&hex[2*written]);
+        if (!word_is_eight_hex_digits(word)) {
+            break;
+        }
+        const uint64_t bytes = ((word_to_nibbles(word) << 4) | (word_to_nibbles(word) >> 8)) & 0x00FF00FF00FF00FF;
+        for (size_t i = 0; i < 4; i++) {
+            dst8[written+i] = (uint8_t)(bytes >> (16*i));
+        }
+    }
+    for (; (len - 2*written) >= 2; written++) {
+        const int high = DIGIT_VALUE(hex[2*written]);
+        const int low = DIGIT_VALUE(hex[2*written+1]);
+        if ((high >= 16) || (low >= 16)) {
+            break;
+        }
+        dst8[written] = (uint8_t)((high << 4) | low);
+    }
+    return written;
+}
+
+// Encode bytes as pairs of hexadecimal digits
+// The string isn't null terminated, a pointer to its end is returned
+char *cj_hex_encode(char *dst, const void *src, size_t sz, int uppercase)
+{
+    const uint8_t *src8 = (const uint8_t *)src;
+    // Distance between the characters '9' + 1 and 'a' (or 'A')
+    const uint64_t letters_offset = uppercase ? ('A' - '9' - 1) : ('a' - '9' - 1);
+    size_t i = 0;
+    // Encode 4 bytes at a time, spreading each nibble into its own byte
+    for (; (sz - i) >= 4; i += 4) {
+        uint64_t x = 0;
+        for (size_t j = 0; j < 4; j++) {
+            x |= (uint64_t)src8[i+j] << (16*j);
+        }
+        x = ((x >> 4) & 0x000F000F000F000F) | ((x & 0x000F000F000F000F) << 8);
+        const uint64_t letters = ((x + 0x0606060606060606) >> 4) & 0x0101010101010101;
+        store_word(dst, x + 0x3030303030303030 + letters * letters_offset);
+        dst += 8;
+    }
+    for (; i < sz; i++) {
+        *dst++ = (char)VALUE_TO_CHAR(src8[i] >> 4, uppercase);
+        *dst++ = (char)VALUE_TO_CHAR(src8[i] & 0x0F, uppercase);
+    }
+    return dst;
+}
+
+// Escape len characters of src for a JSON string literal, without the quotes, to sized buffer (like snprintf)
+// Returns the length of the escaped string
+size_t cj_escape_json(const char *src, size_t len, char *dst, size_t cap)
+{
+    struct Sink sink;
+    sink_buffer(&sink, dst, &cap);
+    const size_t written = escape_to_sink(&sink, src, len, Escape_json);
+    sink_terminate(&sink);
+    return written;
+}
+
+// Escape len characters of src for a C string literal, without the quotes, to sized buffer (like snprintf)
+// Returns the length of the escaped string
+size_t cj_escape_c(const char *src, size_t len, char *dst, size_t cap)
+{
+    struct Sink sink;
+    sink_buffer(&sink, dst, &cap);
+    const size_t written = escape_to_sink(&sink, src, len, Escape_c);
+    sink_terminate(&sink);
+    return written;
+}
+
+// Writes the code point encoded in UTF-8 to str, returning the length of the encoding
+LIBCJ_FN size_t put_utf8(char *const str, const uint32_t code_point)
+{
+    if (code_point < 0x80) {
+        str[0] = (char)code_point;
+        return 1;
+    }
+    if (code_point < 0x800) {
+        str[0] = (char)(0xC0 | (code_point >> 6));
+        str[1] = (char)(0x80 | (code_point & 0x3F));
+        return 2;
+    }
+    if (code_point < 0x10000) {
+        str[0] = (char)(0xE0 | (code_point >> 12));
+        str[1] = (char)(0x80 | ((code_point >> 6) & 0x3F));
+        str[2] = (char)(0x80 | (code_point & 0x3F));
+        return 3;
+    }
+    str[0] = (char)(0xF0 | (code_point >> 18));
+    str[1] = (char)(0x80 | ((code_point >> 12) & 0x3F));
+    str[2] = (char)(0x80 | ((code_point >> 6) & 0x3F));
+    str[3] = (char)(0x80 | (code_point & 0x3F));
+    return 4;
+}
+
+// Parses the 4 hexadecimal digits of a \u escape sequence, returning -1 if they aren't valid
+LIBCJ_FN long parse_hex4(const char *const str, const size_t len)
+{
+    if (len < 4) {
+        return -1;
+    }
+    long value = 0;
+    for (int i = 0; i < 4; i++) {
+        const int digit = DIGIT_VALUE(str[i]);
+        if (digit >= 16) {
+            return -1;
+        }
+        value = (value << 4) | digit;
+    }
+    return value;
+}
+
+// Decodes the escape sequence at the start of str (after the backslash) into decoded
+// JSON \u sequences are encoded in UTF-8, combining surrogate pairs. C \x sequences take up to
+// 2 hexadecimal digits and octal ones up to 3 digits
+// Returns the amount of characters parsed, or zero if the sequence isn't valid
+static size_t parse_escape(const char *const str, const size_t len, char *const decoded, size_t *const decoded_len, const enum Escape_Style style)
+{
+    *decoded_len = 1;
+    if (len == 0) {
+        return 0;
+    }
+    switch (str[0]) {
+    case '"':
+    case '\\': decoded[0] = str[0]; return 1;
+    case 'b':  decoded[0] = '\b'; return 1;
+    case 'f':  decoded[0] = '\f'; return 1;
+    case 'n':  decoded[0] = '\n'; return 1;
+    case 'r':  decoded[0] = '\r'; return 1;
+    case 't':  decoded[0] = '\t'; return 1;
+    default: break;
+    }
+    if (style == Escape_json) {
+        if (str[0] == '/') {
+            decoded[0] = '/';
+            return 1;
+        }
+        if (str[0] != 'u') {
+            return 0;
+        }
+        const long high = parse_hex4(&str[1], len - 1);
+        if ((high < 0) || ((high & 0xFC00) == 0xDC00)) {
+            return 0;
+        }
+        if ((high & 0xFC00) != 0xD800) {
+            *decoded_len = put_utf8(decoded, (uint32_t)high);
+            return 5;
+        }
+        // High surrogate, that must be followed by a low one
+        if ((len < 11) || (str[5] != '\\') || (str[6] != 'u')) {
+            return 0;
+        }
+        const long low = parse_hex4(&str[7], len - 7);
+        if ((low < 0) || ((low & 0xFC00) != 0xDC00)) {
+            return 0;
+        }
+        *decoded_len = put_utf8(decoded, 0x10000 + (((uint32_t)high - 0xD800) << 10) + ((uint32_t)low - 0xDC00));
+        return 11;
+    }
+    switch (str[0]) {
+    case '\'':
+    case '?': decoded[0] = str[0]; return 1;
+    case 'a': decoded[0] = '\a'; return 1;
+    case 'v': decoded[0] = '\v'; return 1;
+    default: break;
+    }
+    unsigned value = 0;
+    size_t index = 0;
+    if (str[0] == 'x') {
+        for (index = 1; (index < MIN(len, 3)) && (DIGIT_VALUE(str[index]) < 16); index++) {
+            value = (value << 4) | (unsigned)DIGIT_VALUE(str[index]);
+        }
+        if (index == 1) {
+            return 0;
+        }
+    } else {
+        for (; (index < MIN(len, 3)) && (DIGIT_VALUE(str[index]) < 8); index++) {
+            value = (value << 3) | (unsigned)DIGIT_VALUE(str[index]);
+        }
+        if ((index == 0) || (value > 0xFF)) {
+            return 0;
+        }
+    }
+    decoded[0] = (char)value;
+    return index;
+}
+
+// Writes len characters of str with their escape sequences decoded
+// The runs of characters without backslashes are appended with a single copy
+// Returns the length of the decoded string, or SIZE_MAX if an escape sequence isn't valid
+static size_t unescape_to_sink(struct Sink *const sink, const char *const str, const size_t len, const enum Escape_Style style)
+{
+    size_t written = 0;
+    for (size_t index = 0; index < len; ) {
+        size_t end = index;
+        for (; (len - end) >= 8; end += 8) {
+            const int found = word_find_byte(load_word(&str[end]), '\\');
+            if (found < 8) {
+                end += (size_t)found;
+                break;
+            }
+        }
+        while ((end < len) && (str[end] != '\\')) {
+            end++;
+        }
+        sink_append(sink, &str[index], end - index);
+        written += end - index;
+        if (end == len) {
+            break;
+        }
+        char decoded[4];
+        size_t decoded_len;
+        const size_t parsed = parse_escape(&str[end + 1], len - end - 1, decoded, &decoded_len, style);
+        if (parsed == 0) {
+            return SIZE_MAX;
+        }
+        sink_append(sink, decoded, decoded_len);
+        written += decoded_len;
+        index = end + 1 + parsed;
+    }
+    return written;
+}
+
+// Decode the escape sequences of len characters of a JSON string literal, without the quotes,
+// to sized buffer (like snprintf). Returns the length of the decoded string, or SIZE_MAX if
+// an escape sequence isn't valid
+size_t cj_unescape_json(const char *src, size_t len, char *dst, size_t cap)
+{
+    struct Sink sink;
+    sink_buffer(&sink, dst, &cap);
+    const size_t written = unescape_to_sink(&sink, src, len, Escape_json);
+    sink_terminate(&sink);
+    return written;
+}
+
+// Decode the escape sequences of len characters of a C string literal, without the quotes,
+// to sized buffer (like snprintf). Returns the length of the decoded string, or SIZE_MAX if
+// an escape sequence isn't valid
+size_t cj_unescape_c(const char *src, size_t len, char *dst, size_t cap)
+{
+    struct Sink sink;
+    sink_buffer(&sink, dst, &cap);
+    const size_t written = unescape_to_sink(&sink, src, len, Escape_c);
+    sink_terminate(&sink);
+    return written;
+}
 
 //------------------------------------------------------------------------------
 // STDIO.H
@@ -1469,7 +5881,7 @@ int sprintf(char *buf, const char *fmt, ...)
 {
     va_list args;
     va_start(args, fmt);
-    const int written = __vsnprintf(&buf, NULL, fmt, args);
+    const int written = vsprintf(buf, fmt, args);
     va_end(args);
     return written;
 }
@@ -1479,7 +5891,7 @@ int snprintf(char *buf, size_t sz, const char *fmt, ...)
 {
     va_list args;
     va_start(args, fmt);
-    const int written = __vsnprintf(&buf, &sz, fmt, args);
+    const int written = vsnprintf(buf, sz, fmt, args);
     va_end(args);
     return written;
 }
@@ -1487,13 +5899,71 @@ int snprintf(char *buf, size_t sz, const char *fmt, ...)
 // Write formatted data from variable argument list to string
 int vsprintf(char *buf, const char *fmt, va_list args)
 {
-    return __vsnprintf(&buf, NULL, fmt, args);
+    struct Sink sink;
+    sink_buffer(&sink, buf, NULL);
+    return __vsnprintf(&sink, fmt, args);
 }
 
 // Write formatted data from variable argument list to sized buffer
 int vsnprintf(char *buf, size_t sz, const char *fmt, va_list args)
 {
-    return __vsnprintf(&buf, &sz, fmt, args);
+    struct Sink sink;
+    sink_buffer(&sink, buf, &sz);
+    return __vsnprintf(&sink, fmt, args);
+}
+
+// Equivalent to snprintf(buf, sz, "%lld", value), without parsing the format
+int cj_snprintf_i64_(char *buf, size_t sz, long long value)
+{
+    struct Sink sink;
+    sink_buffer(&sink, buf, &sz);
+    const int written = int_to_str(&sink, -1, -1, Flag_None, 10, true, value);
+    sink_terminate(&sink);
+    return written;
+}
+
+// Equivalent to snprintf(buf, sz, "%llu", value), without parsing the format
+int cj_snprintf_u64_(char *buf, size_t sz, unsigned long long value)
+{
+    struct Sink sink;
+    sink_buffer(&sink, buf, &sz);
+    const int written = int_to_str(&sink, -1, -1, Flag_None, 10, false, (intmax_t)value);
+    sink_terminate(&sink);
+    return written;
+}
+
+// Equivalent to snprintf(buf, sz, "%s", str), without parsing the format
+int cj_snprintf_str_(char *buf, size_t sz, const char *str)
+{
+    struct Sink sink;
+    sink_buffer(&sink, buf, &sz);
+    const int written = put_string(&sink, -1, -1, false, str);
+    sink_terminate(&sink);
+    return written;
+}
+
+// Equivalent to snprintf(buf, sz, "%s=%s", a, b) with any separator, without parsing the format
+int cj_snprintf_str_str_(char *buf, size_t sz, const char *a, char separator, const char *b)
+{
+    struct Sink sink;
+    sink_buffer(&sink, buf, &sz);
+    int written = put_string(&sink, -1, -1, false, a);
+    sink_putc(&sink, separator);
+    written += 1 + put_string(&sink, -1, -1, false, b);
+    sink_terminate(&sink);
+    return written;
+}
+
+// Equivalent to snprintf(buf, sz, "%s=%lld", a, value) with any separator, without parsing the format
+int cj_snprintf_str_i64_(char *buf, size_t sz, const char *a, char separator, long long value)
+{
+    struct Sink sink;
+    sink_buffer(&sink, buf, &sz);
+    int written = put_string(&sink, -1, -1, false, a);
+    sink_putc(&sink, separator);
+    written += 1 + int_to_str(&sink, -1, -1, Flag_None, 10, true, value);
+    sink_terminate(&sink);
+    return written;
 }
 
 // Read formatted data from string
@@ -1592,35 +6062,38 @@ int sscanf(const char *buf, const char *fmt, ...)
         buf_cursor += parsed_chars;                                           \
     } while (0)
 
-// TODO: long double is not currently supported
-#define SCANF_HANDLE_FLOAT()                                               \
-    do {                                                                   \
-        double value;                                                      \
-        SKIP_WHITESPACES(buf_cursor);                                      \
-        const int parsed_chars = str_to_double(buf_cursor, width, &value); \
-        if (parsed_chars == 0) {                                           \
-            goto vsscanf_error;                                            \
-        }                                                                  \
-        if (!assignment_suppression) {                                     \
-            void *ptr = va_arg(args, void *);                              \
-            switch (modifier) {                                            \
-            case Modifier_long:                                            \
-                *(double *)ptr = (double)value;                            \
-                break;                                                     \
-            case Modifier_ldouble:                                         \
-                *(long double *)ptr = (long double)value;                  \
-                break;                                                     \
-            case Modifier_char:                                            \
-            case Modifier_short:                                           \
-            case Modifier_llong:                                           \
-            case Modifier_None:                                            \
-            default:                                                       \
-                *(float *)ptr = (float)value;                              \
-                break;                                                     \
-            }                                                              \
-            count++;                                                       \
-        }                                                                  \
-        buf_cursor += parsed_chars;                                        \
+#define SCANF_HANDLE_FLOAT()                                                  \
+    do {                                                                      \
+        struct Decimal dec;                                                   \
+        const char *end = NULL;                                               \
+        SKIP_WHITESPACES(buf_cursor);                                         \
+        if (width >= 0) {                                                     \
+            for (end = buf_cursor; ((end - buf_cursor) < width) && (*end != '\0'); end++); \
+        }                                                                     \
+        const int parsed_chars = str_to_decimal(buf_cursor, end, &dec);       \
+        if (parsed_chars == 0) {                                              \
+            goto vsscanf_error;                                               \
+        }                                                                     \
+        if (!assignment_suppression) {                                        \
+            void *ptr = va_arg(args, void *);                                 \
+            switch (modifier) {                                               \
+            case Modifier_long:                                               \
+                *(double *)ptr = decimal_to_double(&dec);                     \
+                break;                                                        \
+            case Modifier_ldouble:                                            \
+                *(long double *)ptr = decimal_to_long_double(&dec);           \
+                break;                                                        \
+            case Modifier_char:                                               \
+            case Modifier_short:                                              \
+            case Modifier_llong:                                              \
+            case Modifier_None:                                               \
+            default:                                                          \
+                *(float *)ptr = decimal_to_float(&dec);                       \
+                break;                                                        \
+            }                                                                 \
+            count++;                                                          \
+        }                                                                     \
+        buf_cursor += parsed_chars;                                           \
     } while (0)
 
 // Read formatted data from string into variable argument list
@@ -1732,6 +6205,9 @@ int vsscanf(const char *buf, const char *fmt, va_list args)
                 }
                 ADVANCE_CURSOR(buf_cursor);
                 break;
+            case Fmt_json:
+            case Fmt_cstr:
+            case Fmt_custom:
             case Fmt_unknown:
                 // Handle scansets
                 if (*cursor == '['){
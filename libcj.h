@@ -29,11 +29,16 @@
 
 #include <stdarg.h>
 #include <stddef.h>
+#include <stdint.h>
 
 #ifndef __GNUC__
 #define __attribute__(a)
 #endif
 
+#if defined(__unix__) || defined(__APPLE__)
+#define LIBCJ_POSIX
+#endif
+
 int isalnum(int c);
 int isalpha(int c);
 int isblank(int c);
@@ -85,7 +90,34 @@ unsigned long long strtoull(const char *str, char **endptr, int base);
 double atof(const char *str);
 float strtof(const char *str, char **endptr);
 double strtod(const char *str, char **endptr);
+// long double is parsed and printed exactly in the x87 extended precision format and when it's
+// the same as double. Other formats (double-double, binary128) are rounded to double precision
 long double strtold(const char *str, char **endptr);
+// Bulk version of strtod for fields separated by 'separator'. This function isn't defined by standard-C
+size_t cj_parse_f64_array(const char *str, size_t sz, char separator, double *values, size_t count);
+// Conversion between bytes and hexadecimal strings. These functions aren't defined by standard-C
+size_t cj_hex_decode(void *dst, const char *hex, size_t len);
+char *cj_hex_encode(char *dst, const void *src, size_t sz, int uppercase);
+// Escaping for JSON and C string literals (without the quotes) to sized buffer (like snprintf), returning
+// the length of the output. The unescaping functions return SIZE_MAX if an escape sequence isn't valid
+// These functions aren't defined by standard-C. printf extends them to strings with %J (JSON) and %Q (C),
+// adding the quotes with the '#' flag
+size_t cj_escape_json(const char *src, size_t len, char *dst, size_t cap);
+size_t cj_escape_c(const char *src, size_t len, char *dst, size_t cap);
+size_t cj_unescape_json(const char *src, size_t len, char *dst, size_t cap);
+size_t cj_unescape_c(const char *src, size_t len, char *dst, size_t cap);
+// Fast integer to string conversions, returning the end of the string. These functions aren't defined by standard-C
+char *cj_i64toa(int64_t value, char *str);
+char *cj_u64toa(uint64_t value, char *str);
+char *cj_u64toa_hex(uint64_t value, char *str, int uppercase);
+// Integer arrays written in decimal, separated by 'separator', to sized buffer (like snprintf)
+// These functions aren't defined by standard-C
+size_t cj_format_i64_array(const int64_t *values, size_t count, char separator, char *out, size_t cap);
+size_t cj_format_u64_array(const uint64_t *values, size_t count, char separator, char *out, size_t cap);
+size_t cj_format_i32_array(const int32_t *values, size_t count, char separator, char *out, size_t cap);
+size_t cj_format_u32_array(const uint32_t *values, size_t count, char separator, char *out, size_t cap);
+// Shortest decimal string that converts back to the same double. This function isn't defined by standard-C
+char *cj_dtoa_shortest(double value, char *str);
 
 int sprintf(char *buf, const char *fmt, ...)
     __attribute__((format(printf, 2, 3)));
@@ -93,14 +125,337 @@ int snprintf(char *buf, size_t sz, const char *fmt, ...)
     __attribute__((format(printf, 3, 4)));
 int vsprintf(char *buf, const char *fmt, va_list args);
 int vsnprintf(char *buf, size_t sz, const char *fmt, va_list args);
+// Writers used by snprintf calls with constant formats, that shouldn't be called directly
+int cj_snprintf_i64_(char *buf, size_t sz, long long value);
+int cj_snprintf_u64_(char *buf, size_t sz, unsigned long long value);
+int cj_snprintf_str_(char *buf, size_t sz, const char *str);
+int cj_snprintf_str_str_(char *buf, size_t sz, const char *a, char separator, const char *b);
+int cj_snprintf_str_i64_(char *buf, size_t sz, const char *a, char separator, long long value);
+
+// Calls of snprintf with a constant format that is "%d", "%u", "%ld", "%lu", "%lld", "%llu", "%s",
+// "%s=%s" or "%s=%d" go straight to the writers above when the arguments have the expected types,
+// skipping the format parsing and the variable argument list. Any other call is left unchanged
+// It needs C11 for _Generic. Define LIBCJ_NO_CONSTANT_FMT before including this header to disable it
+#if defined(__GNUC__) && !defined(__cplusplus) && defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 201112L) && \
+    !defined(LIBCJ_NO_CONSTANT_FMT)
+#define CJ_FMT_EQ(fmt, str) (__builtin_constant_p(fmt) && ((fmt) != 0) && (__builtin_strcmp((fmt), (str)) == 0))
+#define CJ_IS_TYPE(x, type) _Generic((x), type: 1, default: 0)
+#define CJ_AS_TYPE(x, type) _Generic((x), type: (x), default: (type)0)
+#define CJ_IS_STR(x)        _Generic((x), char *: 1, const char *: 1, default: 0)
+#define CJ_AS_STR(x)        _Generic((x), char *: (x), const char *: (x), default: (const char *)0)
+
+#define CJ_SNPRINTF_N(buf, sz, ...) (snprintf)(buf, sz, __VA_ARGS__)
+#define CJ_SNPRINTF_1(buf, sz, fmt, a)                                                                                   \
+    ((CJ_FMT_EQ(fmt, "%d") && CJ_IS_TYPE(a, int)) ? cj_snprintf_i64_(buf, sz, CJ_AS_TYPE(a, int)) :                     \
+     (CJ_FMT_EQ(fmt, "%u") && CJ_IS_TYPE(a, unsigned)) ? cj_snprintf_u64_(buf, sz, CJ_AS_TYPE(a, unsigned)) :           \
+     (CJ_FMT_EQ(fmt, "%ld") && CJ_IS_TYPE(a, long)) ? cj_snprintf_i64_(buf, sz, CJ_AS_TYPE(a, long)) :                  \
+     (CJ_FMT_EQ(fmt, "%lu") && CJ_IS_TYPE(a, unsigned long)) ? cj_snprintf_u64_(buf, sz, CJ_AS_TYPE(a, unsigned long)) : \
+     (CJ_FMT_EQ(fmt, "%lld") && CJ_IS_TYPE(a, long long)) ? cj_snprintf_i64_(buf, sz, CJ_AS_TYPE(a, long long)) :       \
+     (CJ_FMT_EQ(fmt, "%llu") && CJ_IS_TYPE(a, unsigned long long)) ?                                                     \
+        cj_snprintf_u64_(buf, sz, CJ_AS_TYPE(a, unsigned long long)) :                                                  \
+     (CJ_FMT_EQ(fmt, "%s") && CJ_IS_STR(a)) ? cj_snprintf_str_(buf, sz, CJ_AS_STR(a)) :                                 \
+     (snprintf)(buf, sz, fmt, a))
+#define CJ_SNPRINTF_2(buf, sz, fmt, a, b)                                                                                \
+    ((CJ_FMT_EQ(fmt, "%s=%s") && CJ_IS_STR(a) && CJ_IS_STR(b)) ?                                                         \
+        cj_snprintf_str_str_(buf, sz, CJ_AS_STR(a), '=', CJ_AS_STR(b)) :                                                \
+     (CJ_FMT_EQ(fmt, "%s=%d") && CJ_IS_STR(a) && CJ_IS_TYPE(b, int)) ?                                                   \
+        cj_snprintf_str_i64_(buf, sz, CJ_AS_STR(a), '=', CJ_AS_TYPE(b, int)) :                                          \
+     (snprintf)(buf, sz, fmt, a, b))
+// Selects the macro by the amount of arguments after the size (up to 64)
+#define CJ_SNPRINTF_SELECT(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16,                        \
+    _17, _18, _19, _20, _21, _22, _23, _24, _25, _26, _27, _28, _29, _30, _31, _32, _33, _34, _35, _36, _37, _38, _39, \
+    _40, _41, _42, _43, _44, _45, _46, _47, _48, _49, _50, _51, _52, _53, _54, _55, _56, _57, _58, _59, _60, _61, _62, \
+    _63, _64, name, ...) name
+#define snprintf(buf, sz, ...)                                                                                        \
+    CJ_SNPRINTF_SELECT(__VA_ARGS__,                                                                                   \
+        CJ_SNPRINTF_N, CJ_SNPRINTF_N, CJ_SNPRINTF_N, CJ_SNPRINTF_N, CJ_SNPRINTF_N, CJ_SNPRINTF_N, CJ_SNPRINTF_N,      \
+        CJ_SNPRINTF_N, CJ_SNPRINTF_N, CJ_SNPRINTF_N, CJ_SNPRINTF_N, CJ_SNPRINTF_N, CJ_SNPRINTF_N, CJ_SNPRINTF_N,      \
+        CJ_SNPRINTF_N, CJ_SNPRINTF_N, CJ_SNPRINTF_N, CJ_SNPRINTF_N, CJ_SNPRINTF_N, CJ_SNPRINTF_N, CJ_SNPRINTF_N,      \
+        CJ_SNPRINTF_N, CJ_SNPRINTF_N, CJ_SNPRINTF_N, CJ_SNPRINTF_N, CJ_SNPRINTF_N, CJ_SNPRINTF_N, CJ_SNPRINTF_N,      \
+        CJ_SNPRINTF_N, CJ_SNPRINTF_N, CJ_SNPRINTF_N, CJ_SNPRINTF_N, CJ_SNPRINTF_N, CJ_SNPRINTF_N, CJ_SNPRINTF_N,      \
+        CJ_SNPRINTF_N, CJ_SNPRINTF_N, CJ_SNPRINTF_N, CJ_SNPRINTF_N, CJ_SNPRINTF_N, CJ_SNPRINTF_N, CJ_SNPRINTF_N,      \
+        CJ_SNPRINTF_N, CJ_SNPRINTF_N, CJ_SNPRINTF_N, CJ_SNPRINTF_N, CJ_SNPRINTF_N, CJ_SNPRINTF_N, CJ_SNPRINTF_N,      \
+        CJ_SNPRINTF_N, CJ_SNPRINTF_N, CJ_SNPRINTF_N, CJ_SNPRINTF_N, CJ_SNPRINTF_N, CJ_SNPRINTF_N, CJ_SNPRINTF_N,      \
+        CJ_SNPRINTF_N, CJ_SNPRINTF_N, CJ_SNPRINTF_N, CJ_SNPRINTF_N, CJ_SNPRINTF_N,                                    \
+        CJ_SNPRINTF_2, CJ_SNPRINTF_1, CJ_SNPRINTF_N, ~)(buf, sz, __VA_ARGS__)
+#endif
+// Format strings compiled once in literal spans and conversions, to be executed several times
+// These functions aren't defined by standard-C
+#define CJ_FMT_MAX_OPS 32
+typedef struct {
+    uint32_t literal_begin; // Offset in the format string of the literal characters preceding the conversion
+    uint32_t literal_length;
+    int width;
+    int precision;
+    unsigned char flags;
+    unsigned char specifier;
+    unsigned char modifier;
+    unsigned char letter; // Of custom conversions
+} cj_fmt_op;
+typedef struct {
+    const char *fmt;
+    int count; // Amount of ops, or -1 if the format string couldn't be compiled
+    cj_fmt_op ops[CJ_FMT_MAX_OPS];
+} cj_fmt_compiled;
+cj_fmt_compiled cj_fmt_compile(const char *fmt);
+int cj_fmt_snprintf(const cj_fmt_compiled *compiled, char *buf, size_t sz, ...);
+int cj_fmt_vsnprintf(const cj_fmt_compiled *compiled, char *buf, size_t sz, va_list args);
+// Custom conversions for letters unused by the standard ones and %J and %Q (like register_printf_function of glibc)
+// The handler receives the argument of the conversion, which must be a pointer, and writes straight to
+// the output of the printf function. Formats compiled with cj_fmt_compile before the registration
+// don't recognize the new letter, and the format checks of the compiler report it as unknown
+// These functions aren't defined by standard-C
+typedef struct cj_fmt_output cj_fmt_output;
+typedef struct {
+    int width; // -1 if not informed
+    int precision; // -1 if not informed
+    int left_justify; // Flags
+    int plus;
+    int space;
+    int alternative;
+    int zero_pad;
+    char specifier;
+} cj_fmt_spec;
+typedef void (*cj_fmt_handler)(cj_fmt_output *out, const cj_fmt_spec *spec, const void *arg, void *ctx);
+int cj_fmt_register(char specifier, cj_fmt_handler handler, void *ctx);
+void cj_fmt_write(cj_fmt_output *out, const char *str, size_t len);
+void cj_fmt_write_padded(cj_fmt_output *out, const cj_fmt_spec *spec, const char *str);
+int cj_fmt_writef(cj_fmt_output *out, const char *fmt, ...)
+    __attribute__((format(printf, 2, 3)));
+// Length of the output of a format, as returned by snprintf(NULL, 0, fmt, ...), but without generating
+// the characters that would be discarded. These functions aren't defined by standard-C
+int cj_fmt_length(const char *fmt, ...)
+    __attribute__((format(printf, 1, 2)));
+int cj_fmt_vlength(const char *fmt, va_list args);
+// Formatting resumed across several buffers, for output larger than the buffer at hand, like
+// non-blocking sockets. cj_fmt_resume returns the amount of characters written to the buffer
+// (without null termination), and zero once the output is complete
+// These functions aren't defined by standard-C
+typedef struct {
+    const char *fmt; // Position in the format string where formatting continues
+    va_list args; // Arguments from that position onward
+    size_t skip; // Characters of the conversion at that position already written
+    size_t source; // Characters of the string of that conversion already written (%s, %J and %Q)
+    int padding; // Padding of that string conversion, or -1 if it didn't start
+    int written; // Characters written before that position
+} cj_fmt_state;
+void cj_fmt_state_init(cj_fmt_state *state, const char *fmt, va_list args);
+void cj_fmt_state_end(cj_fmt_state *state);
+size_t cj_fmt_resume(cj_fmt_state *state, char *buf, size_t sz);
+// Formats an array of rows (usually structs) with the same compiled format into a single buffer, reading
+// the arguments from the fields of each row at the given offsets. The parallel version splits the rows
+// among threads and writes the chunks in order. These functions aren't defined by standard-C
+int cj_format_rows(const cj_fmt_compiled *compiled, const void *base, size_t stride, size_t nrows,
+    const size_t *field_offsets, char *out, size_t cap);
+int cj_format_rows_parallel(const cj_fmt_compiled *compiled, const void *base, size_t stride, size_t nrows,
+    const size_t *field_offsets, char *out, size_t cap, unsigned threads);
+// The printf functions keep the formats they compile in a thread local cache, unless LIBCJ_NO_FMT_CACHE
+// is defined when building lib-cj. The cache takes about 5 KB of thread local storage in each thread, and
+// holds formats shorter than 128 characters with up to 7 conversions. This function isn't defined by standard-C
+typedef struct {
+    unsigned long long hits;
+    unsigned long long misses;
+} cj_fmt_cache_stats;
+cj_fmt_cache_stats cj_fmt_cache_get_stats(void);
+// Formatting without a format string: the type of each argument selects its conversion at compile time
+// cj_print(buf, sz, "id=", id, " name=", cj_width(name, -10), " mask=", cj_hex(mask)) writes each
+// argument in turn, with snprintf semantics for buf, sz and the returned value. Integers are written in
+// decimal, floating points as %g (or %.Nf with a precision), characters and strings as they are and
+// other pointers as %p. Character constants like 'a' have type int in C, so they are written as integers
+// A negative width left justifies, and the precision of integers pads with zeros
+// These functions aren't defined by standard-C
+typedef enum {
+    CJ_ARG_END,
+    CJ_ARG_INT,
+    CJ_ARG_UINT,
+    CJ_ARG_DOUBLE,
+    CJ_ARG_LDOUBLE,
+    CJ_ARG_CHAR,
+    CJ_ARG_STR,
+    CJ_ARG_PTR,
+} cj_arg_type;
+typedef struct {
+    unsigned char type;
+    unsigned char size; // Size of integers, in bytes
+    unsigned char hex;
+    int width;
+    int precision;
+    union {
+        long long i;
+        unsigned long long u;
+        double f;
+        const char *s;
+        const void *p;
+    } value;
+    long double lf; // Kept out of the union, whose ABI with long double changed across GCC versions
+} cj_arg;
+int cj_print_args(char *buf, size_t sz, const cj_arg *args);
+#ifndef __cplusplus
+static inline cj_arg cj_arg_signed(const long long x, const size_t size)
+{
+    cj_arg arg = {CJ_ARG_INT, (unsigned char)size, 0, -1, -1, {0}, 0};
+    arg.value.i = x;
+    return arg;
+}
+static inline cj_arg cj_arg_unsigned(const unsigned long long x, const size_t size)
+{
+    cj_arg arg = {CJ_ARG_UINT, (unsigned char)size, 0, -1, -1, {0}, 0};
+    arg.value.u = x;
+    return arg;
+}
+static inline cj_arg cj_arg_bool(const _Bool x) { return cj_arg_unsigned(x, sizeof(x)); }
+static inline cj_arg cj_arg_schar(const signed char x) { return cj_arg_signed(x, sizeof(x)); }
+static inline cj_arg cj_arg_uchar(const unsigned char x) { return cj_arg_unsigned(x, sizeof(x)); }
+static inline cj_arg cj_arg_short(const short x) { return cj_arg_signed(x, sizeof(x)); }
+static inline cj_arg cj_arg_ushort(const unsigned short x) { return cj_arg_unsigned(x, sizeof(x)); }
+static inline cj_arg cj_arg_int(const int x) { return cj_arg_signed(x, sizeof(x)); }
+static inline cj_arg cj_arg_uint(const unsigned int x) { return cj_arg_unsigned(x, sizeof(x)); }
+static inline cj_arg cj_arg_long(const long x) { return cj_arg_signed(x, sizeof(x)); }
+static inline cj_arg cj_arg_ulong(const unsigned long x) { return cj_arg_unsigned(x, sizeof(x)); }
+static inline cj_arg cj_arg_llong(const long long x) { return cj_arg_signed(x, sizeof(x)); }
+static inline cj_arg cj_arg_ullong(const unsigned long long x) { return cj_arg_unsigned(x, sizeof(x)); }
+static inline cj_arg cj_arg_char(const char x)
+{
+    cj_arg arg = {CJ_ARG_CHAR, sizeof(x), 0, -1, -1, {0}, 0};
+    arg.value.i = x;
+    return arg;
+}
+static inline cj_arg cj_arg_double(const double x)
+{
+    cj_arg arg = {CJ_ARG_DOUBLE, sizeof(x), 0, -1, -1, {0}, 0};
+    arg.value.f = x;
+    return arg;
+}
+static inline cj_arg cj_arg_ldouble(const long double x)
+{
+    cj_arg arg = {CJ_ARG_LDOUBLE, sizeof(x), 0, -1, -1, {0}, 0};
+    arg.lf = x;
+    return arg;
+}
+static inline cj_arg cj_arg_str(const char *const x)
+{
+    cj_arg arg = {CJ_ARG_STR, sizeof(x), 0, -1, -1, {0}, 0};
+    arg.value.s = x;
+    return arg;
+}
+static inline cj_arg cj_arg_ptr(const void *const x)
+{
+    cj_arg arg = {CJ_ARG_PTR, sizeof(x), 0, -1, -1, {0}, 0};
+    arg.value.p = x;
+    return arg;
+}
+static inline cj_arg cj_arg_arg(const cj_arg x) { return x; }
+static inline cj_arg cj_arg_width(cj_arg x, const int width) { x.width = width; return x; }
+static inline cj_arg cj_arg_precision(cj_arg x, const int precision) { x.precision = precision; return x; }
+static inline cj_arg cj_arg_hex(cj_arg x) { x.hex = 1; return x; }
+#define CJ_ARG(x) _Generic((x),                                                                      \
+    _Bool: cj_arg_bool, char: cj_arg_char, signed char: cj_arg_schar, unsigned char: cj_arg_uchar, \
+    short: cj_arg_short, unsigned short: cj_arg_ushort, int: cj_arg_int, unsigned int: cj_arg_uint, \
+    long: cj_arg_long, unsigned long: cj_arg_ulong, long long: cj_arg_llong,                       \
+    unsigned long long: cj_arg_ullong, float: cj_arg_double, double: cj_arg_double,                \
+    long double: cj_arg_ldouble, char *: cj_arg_str, const char *: cj_arg_str, cj_arg: cj_arg_arg, \
+    default: cj_arg_ptr)(x)
+// Modifiers of a single argument, which can be nested
+#define cj_width(x, width)     cj_arg_width(CJ_ARG(x), (width))
+#define cj_prec(x, precision)  cj_arg_precision(CJ_ARG(x), (precision))
+#define cj_hex(x)              cj_arg_hex(CJ_ARG(x))
+// Applies CJ_ARG to each argument (up to 16)
+#define CJ_ARGS_1(a)       CJ_ARG(a)
+#define CJ_ARGS_2(a, ...)  CJ_ARG(a), CJ_ARGS_1(__VA_ARGS__)
+#define CJ_ARGS_3(a, ...)  CJ_ARG(a), CJ_ARGS_2(__VA_ARGS__)
+#define CJ_ARGS_4(a, ...)  CJ_ARG(a), CJ_ARGS_3(__VA_ARGS__)
+#define CJ_ARGS_5(a, ...)  CJ_ARG(a), CJ_ARGS_4(__VA_ARGS__)
+#define CJ_ARGS_6(a, ...)  CJ_ARG(a), CJ_ARGS_5(__VA_ARGS__)
+#define CJ_ARGS_7(a, ...)  CJ_ARG(a), CJ_ARGS_6(__VA_ARGS__)
+#define CJ_ARGS_8(a, ...)  CJ_ARG(a), CJ_ARGS_7(__VA_ARGS__)
+#define CJ_ARGS_9(a, ...)  CJ_ARG(a), CJ_ARGS_8(__VA_ARGS__)
+#define CJ_ARGS_10(a, ...) CJ_ARG(a), CJ_ARGS_9(__VA_ARGS__)
+#define CJ_ARGS_11(a, ...) CJ_ARG(a), CJ_ARGS_10(__VA_ARGS__)
+#define CJ_ARGS_12(a, ...) CJ_ARG(a), CJ_ARGS_11(__VA_ARGS__)
+#define CJ_ARGS_13(a, ...) CJ_ARG(a), CJ_ARGS_12(__VA_ARGS__)
+#define CJ_ARGS_14(a, ...) CJ_ARG(a), CJ_ARGS_13(__VA_ARGS__)
+#define CJ_ARGS_15(a, ...) CJ_ARG(a), CJ_ARGS_14(__VA_ARGS__)
+#define CJ_ARGS_16(a, ...) CJ_ARG(a), CJ_ARGS_15(__VA_ARGS__)
+#define CJ_ARGS_SELECT(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, name, ...) name
+#define CJ_ARGS(...)                                                                                  \
+    CJ_ARGS_SELECT(__VA_ARGS__, CJ_ARGS_16, CJ_ARGS_15, CJ_ARGS_14, CJ_ARGS_13, CJ_ARGS_12, CJ_ARGS_11, \
+        CJ_ARGS_10, CJ_ARGS_9, CJ_ARGS_8, CJ_ARGS_7, CJ_ARGS_6, CJ_ARGS_5, CJ_ARGS_4, CJ_ARGS_3,        \
+        CJ_ARGS_2, CJ_ARGS_1, ~)(__VA_ARGS__)
+#define cj_print(buf, sz, ...) cj_print_args((buf), (sz), (const cj_arg[]){CJ_ARGS(__VA_ARGS__), {0}})
+#endif // __cplusplus
+// Formatted output passed in chunks to a callback (not null terminated). These functions aren't defined by standard-C
+typedef void (*cj_print_callback)(void *ctx, const char *str, size_t len);
+int cj_cbprintf(cj_print_callback cb, void *ctx, const char *fmt, ...)
+    __attribute__((format(printf, 3, 4)));
+int cj_vcbprintf(cj_print_callback cb, void *ctx, const char *fmt, va_list args);
+// Deferred formatting: cj_log_capture stores the index of a compiled format of the ring and the bytes of its
+// arguments (copying the strings) in the ring, and cj_log_decode formats the captured records later
+// Records that don't fit in the free space of the ring are dropped. The arguments of a record take up to 1024 bytes,
+// and longer strings are truncated as if by the precision. These functions aren't defined by standard-C
+typedef struct {
+    unsigned char *buffer;
+    size_t size;
+    size_t first; // Offset of the oldest record
+    size_t used;
+    size_t dropped; // Amount of records that couldn't be captured
+    const cj_fmt_compiled *formats;
+    size_t count;
+} cj_log_ring;
+void cj_log_init(cj_log_ring *ring, void *buffer, size_t size, const cj_fmt_compiled *formats, size_t count);
+int cj_log_capture(cj_log_ring *ring, unsigned fmt_id, ...);
+int cj_log_vcapture(cj_log_ring *ring, unsigned fmt_id, va_list args);
+int cj_log_decode(cj_log_ring *ring, cj_print_callback cb, void *ctx);
+// Growable string builder, the string is always null terminated after the first append
+// The allocator has the semantics of realloc, and is called with size 0 to free the memory
+// These functions aren't defined by standard-C
+typedef void *(*cj_sb_allocator)(void *ctx, void *ptr, size_t size);
+typedef struct {
+    char *str;
+    size_t length;
+    size_t capacity;
+    cj_sb_allocator allocator;
+    void *ctx;
+    int error; // Set when the memory couldn't be allocated
+} cj_sb;
+void cj_sb_init(cj_sb *sb, cj_sb_allocator allocator, void *ctx);
+void cj_sb_free(cj_sb *sb);
+int cj_sb_append(cj_sb *sb, const char *str, size_t len);
+int cj_sb_putc(cj_sb *sb, char c);
+int cj_sb_appendf(cj_sb *sb, const char *fmt, ...)
+    __attribute__((format(printf, 2, 3)));
+int cj_sb_vappendf(cj_sb *sb, const char *fmt, va_list args);
+#ifdef LIBCJ_POSIX
+// Buffered writer over a file descriptor, using a buffer provided by the caller. These functions aren't defined by standard-C
+typedef struct {
+    int fd;
+    char *buffer;
+    size_t size;
+    size_t length; // Amount of characters waiting in the buffer
+    int error; // Set when a write to the file descriptor fails
+} cj_file;
+void cj_file_init(cj_file *file, int fd, char *buffer, size_t size);
+int cj_file_flush(cj_file *file);
+int cj_dprintf(cj_file *file, const char *fmt, ...)
+    __attribute__((format(printf, 2, 3)));
+int cj_vdprintf(cj_file *file, const char *fmt, va_list args);
+#endif // LIBCJ_POSIX
 
 int sscanf(const char *buf, const char *fmt, ...)
     __attribute__((format(scanf, 2, 3)));
 int vsscanf(const char *buf, const char *fmt, va_list args);
 
 // Temporary buffer print function
+// The last 8 outputs of each thread stay valid, in slots of 512 characters. Longer outputs spill to an arena
+// of the thread, that is allocated on first use and is valid until cj_tprintf_reset. Without allocator they
+// are truncated to 4095 characters, taking all the slots, and are valid until the next call of the thread
 char *tprintf(char *fmt, ...)
     __attribute__((format(printf, 1, 2)));
+// Spill arenas of tprintf, whose allocator has the semantics of the one of cj_sb
+// The allocator is shared by all threads and must be set before other threads use tprintf
+// These functions aren't defined by standard-C
+void cj_tprintf_allocator(cj_sb_allocator allocator, void *ctx);
+void cj_tprintf_reset(void);
+void cj_tprintf_free(void);
 
 #endif  // __LIB_CJ
 
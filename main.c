@@ -41,10 +41,15 @@ extern int fprintf (FILE *stream, const char *format, ...);
 #include <stdio.h>
 #endif // USE_LIB_CJ
 
+#include <float.h>
 #include <limits.h>
 #include <math.h>
 #include <stdlib.h>
 
+#if defined(USE_LIB_CJ) && defined(LIBCJ_POSIX)
+#include <unistd.h>
+#endif
+
 #define TEST_IMPLEMENTATION
 #include "test.h"
 
@@ -637,6 +642,16 @@ static void check_strtol(void)
     EXPECT_LONG(strtol("-7fffffffffffffff", NULL, 16), -9223372036854775807L);
     EXPECT_LONG(strtol("0x7f0", NULL, 16), 2032);
     EXPECT_LONG(strtol("0x7fffffffffffffff", NULL, 16), LONG_MAX);
+    EXPECT_LONG(strtol("0x00000000000000000000DeadBeef", NULL, 16), 3735928559L);
+    EXPECT_LONG(strtol("f23456789abcdef0", NULL, 16), LONG_MAX);
+    EXPECT_LONG(strtol("-f23456789abcdef0", NULL, 16), LONG_MIN);
+    // Binary numbers
+    EXPECT_LONG(strtol("  101", NULL, 2), 5L);
+    EXPECT_LONG(strtol("1012", &endptr, 2), 5L);
+    EXPECT_CHAR(*endptr, '2');
+    EXPECT_LONG(strtol("111111111111111111111111111111111111111111111111111111111111111", NULL, 2), LONG_MAX);
+    EXPECT_LONG(strtol("-1000000000000000000000000000000000000000000000000000000000000000", NULL, 2), LONG_MIN);
+    EXPECT_LONG(strtol("1000000000000000000000000000000000000000000000000000000000000000", NULL, 2), LONG_MAX);
     // Informing zero base
     EXPECT_LONG(strtol("  85", NULL, 0), 85L);
     EXPECT_LONG(strtol("  85", &endptr, 0), 85L);
@@ -886,6 +901,14 @@ static void check_strtoull(void)
     EXPECT_ULLONG(strtoull("fffffffffffffffe", NULL, 16), 18446744073709551614ULL);
     EXPECT_ULLONG(strtoull("0x7f0", NULL, 16), 2032);
     EXPECT_ULLONG(strtoull("0xffffffffffffffff", NULL, 16), ULLONG_MAX);
+    EXPECT_ULLONG(strtoull("0x1ffffffffffffffff", NULL, 16), ULLONG_MAX);
+    EXPECT_ULLONG(strtoull("0123456789ABCDEFx", &endptr, 16), 0x0123456789abcdefULL);
+    EXPECT_CHAR(*endptr, 'x');
+    EXPECT_ULLONG(strtoull("-ff", NULL, 16), -255ULL);
+    // Binary numbers
+    EXPECT_ULLONG(strtoull("  101", NULL, 2), 5ULL);
+    EXPECT_ULLONG(strtoull("1111111111111111111111111111111111111111111111111111111111111111", NULL, 2), ULLONG_MAX);
+    EXPECT_ULLONG(strtoull("11111111111111111111111111111111111111111111111111111111111111111", NULL, 2), ULLONG_MAX);
     // Informing zero base
     EXPECT_ULLONG(strtoull("  85", NULL, 0), 85ULL);
     EXPECT_ULLONG(strtoull("  85", &endptr, 0), 85ULL);
@@ -980,6 +1003,12 @@ static void check_strtof(void)
     EXPECT_CHAR(*endptr, 'e');
     EXPECT_FLOAT(strtof("1.2e-3alpha", &endptr), 1.2e-3f);
     EXPECT_CHAR(*endptr, 'a');
+    // Correct rounding in hard cases
+    EXPECT_FLOAT(strtof("16777217", NULL), 16777216.0f);
+    EXPECT_FLOAT(strtof("1.00000005960464477550", NULL), 1.0000001f);
+    EXPECT_FLOAT(strtof("1.4e-45", NULL), 1.4e-45f);
+    EXPECT_FLOAT(strtof("3.4028235e38", NULL), FLT_MAX);
+    EXPECT_FLOAT(strtof("0.001", NULL), 0.001f);
 }
 
 static void check_strtod(void)
@@ -1013,6 +1042,18 @@ static void check_strtod(void)
     EXPECT_CHAR(*endptr, 'e');
     EXPECT_DOUBLE(strtod("1.5e-3alpha", &endptr), 1.5e-3);
     EXPECT_CHAR(*endptr, 'a');
+    // Correct rounding in hard cases
+    EXPECT_DOUBLE(strtod("9007199254740993", NULL), 9007199254740992.0);
+    EXPECT_DOUBLE(strtod("9007199254740993.0000000000000000001", NULL), 9007199254740994.0);
+    EXPECT_DOUBLE(strtod("2.2250738585072011e-308", NULL), 2.2250738585072011e-308);
+    EXPECT_DOUBLE(strtod("4.9e-324", NULL), 4.9e-324);
+    EXPECT_DOUBLE(strtod("2.4703282292062327e-324", NULL), 0.0);
+    EXPECT_DOUBLE(strtod("2.4703282292062328e-324", NULL), 4.9e-324);
+    EXPECT_DOUBLE(strtod("1.7976931348623157e308", NULL), DBL_MAX);
+    EXPECT_DOUBLE(strtod("0.1000000000000000055511151231257827021181583404541015625", NULL), 0.1);
+    EXPECT_DOUBLE(strtod("1234567890.12345678", NULL), 1234567890.12345678);
+    EXPECT_DOUBLE(strtod("1e400", NULL), HUGE_VAL);
+    EXPECT_DOUBLE(strtod("-1e-400", NULL), -0.0);
 }
 
 static void check_strtold(void)
@@ -1047,8 +1088,238 @@ static void check_strtold(void)
     EXPECT_CHAR(*endptr, 'e');
     EXPECT_LDOUBLE(strtold("1.5e-1alpha", &endptr), 1.5e-1L);
     EXPECT_CHAR(*endptr, 'a');
+    // Correct rounding in hard cases
+    EXPECT_LDOUBLE(strtold("12.523", NULL), 12.523L);
+    EXPECT_LDOUBLE(strtold("18446744073709551617", NULL), 18446744073709551616.0L);
+    EXPECT_LDOUBLE(strtold("0.1000000000000000000013552527156068805425093160010874271392822265625", NULL), 0.1L);
+    EXPECT_LDOUBLE(strtold("1.18973149535723176502e+4932", NULL), LDBL_MAX);
+    EXPECT_LDOUBLE(strtold("3.64519953188247460253e-4951", NULL), 3.64519953188247460253e-4951L);
+    EXPECT_LDOUBLE(strtold("1e400", NULL), 1e400L);
+    EXPECT_LDOUBLE(strtold("1e5000", NULL), HUGE_VALL);
+#if defined(USE_LIB_CJ) && LDBL_MANT_DIG == 64
+    // Exact ties between subnormals have 11.5k significant digits, obtained by halving the
+    // digits of odd multiples of the smallest subnormal
+    static char tie[16600];
+    for (int multiple = 3; multiple <= 7; multiple += 2) {
+        const int length = snprintf(tie, sizeof(tie), "%.16500Le", multiple * LDBL_TRUE_MIN);
+        char *exponent = strchr(tie, 'e');
+        int carry = 0;
+        for (char *digit = tie; digit < exponent; digit++) {
+            if (*digit == '.')
+                continue;
+            const int value = carry * 10 + (*digit - '0');
+            *digit = (char)('0' + value / 2);
+            carry = value % 2;
+        }
+        EXPECT_INT(carry, 0);
+        EXPECT_INT(exponent[-1], '0');
+        const long double even = (multiple / 2 + (multiple / 2) % 2) * LDBL_TRUE_MIN;
+        EXPECT_LDOUBLE(strtold(tie, NULL), even);
+        exponent[-1] = '1';
+        EXPECT_LDOUBLE(strtold(tie, NULL), (multiple / 2 + 1) * LDBL_TRUE_MIN);
+        EXPECT_INT(length, (int)strlen(tie));
+    }
+#endif
+}
+
+#ifdef USE_LIB_CJ
+static void check_cj_hex(void)
+{
+    const unsigned char bytes[] = {0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef, 0x00, 0xff, 0x7a};
+    char hex[32] = {0};
+    unsigned char decoded[16];
+    EXPECT_PTR(cj_hex_encode(hex, bytes, sizeof(bytes), 0), &hex[2*sizeof(bytes)]);
+    EXPECT_STR(hex, "0123456789abcdef00ff7a");
+    EXPECT_PTR(cj_hex_encode(hex, bytes, sizeof(bytes), 1), &hex[2*sizeof(bytes)]);
+    EXPECT_STR(hex, "0123456789ABCDEF00FF7A");
+    EXPECT_SIZE(cj_hex_decode(decoded, hex, strlen(hex)), sizeof(bytes));
+    EXPECT_INT(memcmp(decoded, bytes, sizeof(bytes)), 0);
+    EXPECT_SIZE(cj_hex_decode(decoded, "0a1B2c3D4e5F6a7b8c", 18), 9);
+    EXPECT_UCHAR(decoded[0], 0x0a);
+    EXPECT_UCHAR(decoded[5], 0x5f);
+    EXPECT_UCHAR(decoded[8], 0x8c);
+    // Decoding stops at invalid characters and odd lengths
+    EXPECT_SIZE(cj_hex_decode(decoded, "0a1b2c3g4e5f", 12), 3);
+    EXPECT_SIZE(cj_hex_decode(decoded, "0a1b2", 5), 2);
+    EXPECT_SIZE(cj_hex_decode(decoded, "", 0), 0);
+}
+
+static void check_cj_parse_f64_array(void)
+{
+    const char column[] = "85.3,-256.23,0.001,+23,  -375,0,-0,alpha,12.523b3,123e5,123E-2,1e-3,,"
+        "1234567890.12345678,0.000000000000000000001234,98765432109876543210,1e400,-2.5e-310,7";
+    double values[32];
+    const size_t count = cj_parse_f64_array(column, strlen(column), ',', values, 32);
+    EXPECT_SIZE(count, 19);
+    const char *field = column;
+    for (size_t i = 0; i < count; i++) {
+        EXPECT_DOUBLE(values[i], strtod(field, NULL));
+        field = strchr(field, ',') + 1;
+    }
+    EXPECT_DOUBLE(values[0], 85.3);
+    EXPECT_DOUBLE(values[1], -256.23);
+    EXPECT_DOUBLE(values[7], 0.0);
+    EXPECT_DOUBLE(values[8], 12.523);
+    EXPECT_DOUBLE(values[12], 0.0);
+    EXPECT_DOUBLE(values[18], 7.0);
+    // The amount of values is limited by count
+    EXPECT_SIZE(cj_parse_f64_array(column, strlen(column), ',', values, 3), 3);
+    EXPECT_DOUBLE(values[2], 0.001);
+    // Batches larger than the internal batch size
+    char big_column[1024];
+    int len = 0;
+    for (int i = 0; i < 100; i++) {
+        len += snprintf(&big_column[len], sizeof(big_column) - (size_t)len, "%d.5\n", i);
+    }
+    double big_values[128];
+    EXPECT_SIZE(cj_parse_f64_array(big_column, (size_t)len, '\n', big_values, 128), 100);
+    for (int i = 0; i < 100; i++) {
+        EXPECT_DOUBLE(big_values[i], i + 0.5);
+    }
 }
 
+static void check_cj_int_to_str(void)
+{
+    char str[32];
+    EXPECT_PTR(cj_u64toa(0, str), &str[1]);
+    EXPECT_STR(str, "0");
+    EXPECT_PTR(cj_u64toa(9, str), &str[1]);
+    EXPECT_STR(str, "9");
+    EXPECT_PTR(cj_u64toa(10, str), &str[2]);
+    EXPECT_STR(str, "10");
+    EXPECT_PTR(cj_u64toa(12345, str), &str[5]);
+    EXPECT_STR(str, "12345");
+    EXPECT_PTR(cj_u64toa(UINT64_MAX, str), &str[20]);
+    EXPECT_STR(str, "18446744073709551615");
+    EXPECT_PTR(cj_i64toa(-987654321, str), &str[10]);
+    EXPECT_STR(str, "-987654321");
+    EXPECT_PTR(cj_i64toa(INT64_MIN, str), &str[20]);
+    EXPECT_STR(str, "-9223372036854775808");
+    EXPECT_PTR(cj_i64toa(INT64_MAX, str), &str[19]);
+    EXPECT_STR(str, "9223372036854775807");
+    for (uint64_t value = 1, i = 0; i < 20; i++, value *= 10) {
+        char expected[32];
+        snprintf(expected, sizeof(expected), "%llu", (unsigned long long)(value - 1));
+        cj_u64toa(value - 1, str);
+        EXPECT_STR(str, expected);
+        snprintf(expected, sizeof(expected), "%llu", (unsigned long long)value);
+        cj_u64toa(value, str);
+        EXPECT_STR(str, expected);
+    }
+    EXPECT_PTR(cj_u64toa_hex(0, str, 0), &str[1]);
+    EXPECT_STR(str, "0");
+    EXPECT_PTR(cj_u64toa_hex(0xdeadbeef, str, 0), &str[8]);
+    EXPECT_STR(str, "deadbeef");
+    EXPECT_PTR(cj_u64toa_hex(0x1A2B3C, str, 1), &str[6]);
+    EXPECT_STR(str, "1A2B3C");
+    EXPECT_PTR(cj_u64toa_hex(UINT64_MAX, str, 0), &str[16]);
+    EXPECT_STR(str, "ffffffffffffffff");
+}
+
+static void check_cj_format_array(void)
+{
+    static const int64_t i64_values[] = {0, -1, 9, 10, -99999999, 100000000, 1234567890123456, -10000000000000000, INT64_MIN, INT64_MAX};
+    static const uint64_t u64_values[] = {UINT64_MAX, 99999999, 18446744073, 7};
+    static const int32_t i32_values[] = {INT32_MIN, 0, INT32_MAX, -42};
+    static const uint32_t u32_values[] = {UINT32_MAX, 100};
+    const char *i64_expected = "0,-1,9,10,-99999999,100000000,1234567890123456,-10000000000000000,"
+                               "-9223372036854775808,9223372036854775807";
+    char str[128];
+    EXPECT_SIZE(cj_format_i64_array(i64_values, 10, ',', str, sizeof(str)), 106);
+    EXPECT_STR(str, i64_expected);
+    EXPECT_SIZE(cj_format_u64_array(u64_values, 4, ' ', str, sizeof(str)), 43);
+    EXPECT_STR(str, "18446744073709551615 99999999 18446744073 7");
+    EXPECT_SIZE(cj_format_i32_array(i32_values, 4, '\n', str, sizeof(str)), 28);
+    EXPECT_STR(str, "-2147483648\n0\n2147483647\n-42");
+    EXPECT_SIZE(cj_format_u32_array(u32_values, 2, ';', str, sizeof(str)), 14);
+    EXPECT_STR(str, "4294967295;100");
+    EXPECT_SIZE(cj_format_u32_array(u32_values, 0, ';', str, sizeof(str)), 0);
+    EXPECT_STR(str, "");
+    // Truncation at every size
+    for (size_t cap = 0; cap <= 107; cap++) {
+        memset(str, '#', sizeof(str));
+        EXPECT_SIZE(cj_format_i64_array(i64_values, 10, ',', str, cap), 106);
+        if (cap > 0) {
+            EXPECT_SIZED_STR(str, i64_expected, cap - 1);
+            EXPECT_INT(str[cap - 1], '\0');
+        }
+        EXPECT_INT(str[cap], '#');
+    }
+}
+
+static void check_cj_dtoa_shortest(void)
+{
+    char str[32];
+    EXPECT_PTR(cj_dtoa_shortest(0.1, str), &str[3]);
+    EXPECT_STR(str, "0.1");
+    cj_dtoa_shortest(0.3, str);
+    EXPECT_STR(str, "0.3");
+    cj_dtoa_shortest(-1.5, str);
+    EXPECT_STR(str, "-1.5");
+    cj_dtoa_shortest(100.0, str);
+    EXPECT_STR(str, "100");
+    cj_dtoa_shortest(0.001234, str);
+    EXPECT_STR(str, "0.001234");
+    cj_dtoa_shortest(1e-5, str);
+    EXPECT_STR(str, "1e-05");
+    cj_dtoa_shortest(1e16, str);
+    EXPECT_STR(str, "10000000000000000");
+    cj_dtoa_shortest(1e17, str);
+    EXPECT_STR(str, "1e+17");
+    cj_dtoa_shortest(123456789012345680.0, str);
+    EXPECT_STR(str, "1.2345678901234568e+17");
+    cj_dtoa_shortest(1e300, str);
+    EXPECT_STR(str, "1e+300");
+    cj_dtoa_shortest(5e-324, str);
+    EXPECT_STR(str, "5e-324");
+    EXPECT_PTR(cj_dtoa_shortest(-2.2250738585072014e-308, str), &str[24]);
+    EXPECT_STR(str, "-2.2250738585072014e-308");
+    cj_dtoa_shortest(1.7976931348623157e308, str);
+    EXPECT_STR(str, "1.7976931348623157e+308");
+    cj_dtoa_shortest(-0.0, str);
+    EXPECT_STR(str, "-0");
+    cj_dtoa_shortest(-HUGE_VAL, str);
+    EXPECT_STR(str, "-inf");
+    EXPECT_DOUBLE(strtod("0.30000000000000004", NULL), 0.1 + 0.2);
+    cj_dtoa_shortest(0.1 + 0.2, str);
+    EXPECT_STR(str, "0.30000000000000004");
+}
+
+static void check_cj_escape(void)
+{
+    const char *raw = "Tab\there \"quoted\" back\\slash\nbell\a del\x7f caf\xc3\xa9 ctrl\x01" "9";
+    const char *json = "Tab\\there \\\"quoted\\\" back\\\\slash\\nbell\\u0007 del\x7f caf\xc3\xa9 ctrl\\u00019";
+    const char *c = "Tab\\there \\\"quoted\\\" back\\\\slash\\nbell\\a del\\177 caf\xc3\xa9 ctrl\\0019";
+    char str[128];
+    EXPECT_SIZE(cj_escape_json(raw, 52, str, sizeof(str)), 67);
+    EXPECT_STR(str, json);
+    EXPECT_SIZE(cj_unescape_json(json, 67, str, sizeof(str)), 52);
+    EXPECT_STR(str, raw);
+    EXPECT_SIZE(cj_escape_c(raw, 52, str, sizeof(str)), 64);
+    EXPECT_STR(str, c);
+    EXPECT_SIZE(cj_unescape_c(c, 64, str, sizeof(str)), 52);
+    EXPECT_STR(str, raw);
+    // Truncation
+    EXPECT_SIZE(cj_escape_json(raw, 52, str, 6), 67);
+    EXPECT_STR(str, "Tab\\t");
+    EXPECT_SIZE(cj_escape_c(raw, 52, NULL, 0), 64);
+    // Unicode and numeric sequences
+    EXPECT_SIZE(cj_unescape_json("caf\\u00e9 \\ud83d\\ude00\\/", 24, str, sizeof(str)), 11);
+    EXPECT_STR(str, "caf\xc3\xa9 \xf0\x9f\x98\x80/");
+    EXPECT_SIZE(cj_unescape_c("\\x41\\101\\0\\?", 12, str, sizeof(str)), 4);
+    EXPECT_INT(memcmp(str, "AA\0?", 5), 0);
+    // Invalid sequences
+    EXPECT_SIZE(cj_unescape_json("\\a", 2, str, sizeof(str)), SIZE_MAX);
+    EXPECT_SIZE(cj_unescape_json("\\ud83d", 6, str, sizeof(str)), SIZE_MAX);
+    EXPECT_SIZE(cj_unescape_json("\\u12", 4, str, sizeof(str)), SIZE_MAX);
+    EXPECT_SIZE(cj_unescape_c("\\400", 4, str, sizeof(str)), SIZE_MAX);
+    EXPECT_SIZE(cj_unescape_c("end\\", 4, str, sizeof(str)), SIZE_MAX);
+    // Conversions
+    EXPECT_INT(snprintf(str, sizeof(str), "[%#J|%-8Q|%6.2J|%J]", "a\"b", "x\ny", "\t\t\t", (char *)NULL), 31);
+    EXPECT_STR(str, "[\"a\\\"b\"|x\\ny    |  \\t\\t|(null)]");
+}
+#endif // USE_LIB_CJ
+
 static void check_stdlib(void)
 {
     check_atoi();
@@ -1062,6 +1333,14 @@ static void check_stdlib(void)
     check_strtof();
     check_strtod();
     check_strtold();
+#ifdef USE_LIB_CJ
+    check_cj_parse_f64_array();
+    check_cj_hex();
+    check_cj_int_to_str();
+    check_cj_format_array();
+    check_cj_dtoa_shortest();
+    check_cj_escape();
+#endif // USE_LIB_CJ
 }
 
 //------------------------------------------------------------------------------
@@ -1094,6 +1373,13 @@ static void check_snprintf(void)
         EXPECT_STR(buffer, expected);
         EXPECT_INT(ret, (int)strlen(fmt));
     }
+    {
+        char buffer[8];
+        const int ret = snprintf(buffer, sizeof(buffer), "%s, %d%5s", "Hello", 12345, "!");
+        EXPECT_STR(buffer, "Hello, ");
+        EXPECT_INT(ret, 17);
+        EXPECT_INT(snprintf(NULL, 0, "%s, %d%5s", "Hello", 12345, "!"), 17);
+    }
     // Signed decimal integer
     TEST_SNPRINTF("10 -10 -2147483648 2147483647", "%d %d %d %d", 10, -10, INT_MIN, INT_MAX);
     TEST_SNPRINTF("Out of bounds test: -2147483648 -1", "Out of bounds test: %d %d", (1L + INT_MAX), ULONG_MAX);
@@ -1142,6 +1428,13 @@ static void check_snprintf(void)
     TEST_SNPRINTF("Variable length:    1 2    0345   003  004", "Variable length: %*lu %-*lu %.*lu %5.*lu %*.*lu", 4, 1UL, 4, 2UL, 4, 345UL, 3, 3UL, 4, 3, 4UL);
     // Character
     TEST_SNPRINTF("Characters: A c 7", "Characters: %c %c %c", 65, 'c', '7');
+    // Strings
+    TEST_SNPRINTF("[hello] [     hello] [hello     ] [hel] [   he] [     ] [(null)]", "[%s] [%10s] [%-10s] [%.3s] [%5.2s] [%5.0s] [%s]", "hello", "hello", "hello", "hello", "hello", "hello", (char *)NULL);
+    TEST_SNPRINTF("[ (nil)] [(nil)   ]", "[%6.0p] [%-8.2p]", (void *)NULL, (void *)NULL);
+    {
+        const char unterminated[3] = {'a', 'b', 'c'};
+        TEST_SNPRINTF("ab abc", "%.2s %.3s", unterminated, unterminated);
+    }
     // Percent character
     TEST_SNPRINTF("Percent character: %", "Percent character: %%");
     // Unsigned octal
@@ -1160,6 +1453,7 @@ static void check_snprintf(void)
     TEST_SNPRINTF("Testing flags: 0011 12   0x13 0x14 0x0028   0x50 0  0 00 0xaa1 0x0a", "Testing flags: %+04x %-04x %#04x %+#04x %#-8.4x %+#x %#x %#2x %#02x %#04x %#04x", 17, 18, 19, 20, 40, 80, 0, 0, 0, 0xaa1, 0xa);
     TEST_SNPRINTF("Testing flags: 0011 12   0X13 0X14 0X0028   0X50 0  0 00 0XAA1 0X0A", "Testing flags: %+04X %-04X %#04X %+#04X %#-8.4X %+#X %#X %#2X %#02X %#04X %#04X", 17, 18, 19, 20, 40, 80, 0, 0, 0, 0xaa1, 0xa);
     TEST_SNPRINTF("Variable length:    1 2    0159   003  004", "Variable length: %*x %-*x %.*x %5.*x %*.*x", 4, 1, 4, 2, 4, 345, 3, 3, 4, 3, 4);
+    TEST_SNPRINTF("Limits: -9223372036854775808 1777777777777777777777 0XFFFFFFFFFFFFFFFF", "Limits: %lld %llo %#llX", LLONG_MIN, ULLONG_MAX, ULLONG_MAX);
     // Pointer address
     TEST_SNPRINTF("Pointer addresses: 0x456789ab 0x6789ab (nil)", "Pointer addresses: %p %p %p", (void*)0x456789AB, (void*)0x006789AB, NULL);
     TEST_SNPRINTF("Testing flags:    (nil)    (nil)    (nil) (nil)       (nil) (nil)", "Testing flags: %8p % 8p %08p %-8p %+8p %2.6p", NULL, NULL, NULL, NULL, NULL, NULL);
@@ -1182,8 +1476,27 @@ static void check_snprintf(void)
     TEST_SNPRINTF("Testing flags: 1.012340E-05 +1.234560E-06 -1.234560E-06 2.345678E+06 8.8946E+05", "Testing flags: %08E %+08E %08E %-09E %-08.4E", 10.1234e-6f, 1.23456e-6f, -1.23456e-6f, 2.345678e+6f, 889.45678e+3f);
     TEST_SNPRINTF("Fixed length:    1.000000e+00 2.000000e+00    3.45e+02  3.00e+00 4.000e+00", "Fixed length: %15e %-15e %.2e %9.2e %9.3e", 1.0f, 2.0f, 345.0f, 3.0f, 4.0f);
     TEST_SNPRINTF("Variable length:    1.000000e+00 2.000000e+00    3.45e+02  3.00e+00 4.000e+00", "Variable length: %*e %-*e %.*e %9.*e %*.*e", 15, 1.0f, 15, 2.0f, 2, 345.0f, 2, 3.0f, 9, 3, 4.0f);
+    // Exact decimal expansions, rounded to nearest (ties to even)
+    TEST_SNPRINTF("0.10000000000000000555 0 2 4 0.125 0.12", "%.20f %.0f %.0f %.0f %.3f %.2f", 0.1, 0.5, 2.5, 3.5, 0.125, 0.125);
+    TEST_SNPRINTF("123456789012345.671875000 -0.001 0.2 999999.99 0.000000000 0.0001 1", "%.9f %.3f %.1f %.2f %.9f %.4f %.0f", 123456789012345.678, -0.0005, 0.25, 999999.995, 1e-10, 5e-5, 0.5000000001);
+    TEST_SNPRINTF("1.000000e+300 1e+300 1.0000000000000001e+300", "%e %g %.16e", 1e300, 1e300, 1e300);
+    TEST_SNPRINTF("1000000000000000052504760255204420248704468581108159154915854115511802457988908195786371375080447864043704443832883878176942523235360430575644792184786706982848387200926575803737830233794788090059368953234970799945081119038967640880074652742780142494579258788820056842838115669472196386865459400540160.000000", "%f", 1e300);
+    TEST_SNPRINTF("4.940656e-324 2.225074e-308 1.797693e+308", "%e %e %e", 4.9e-324, DBL_MIN, DBL_MAX);
+    TEST_SNPRINTF("inf -inf INF   inf +inf", "%f %e %G %5g %+f", HUGE_VAL, -HUGE_VAL, HUGE_VAL, HUGE_VAL, HUGE_VAL);
+    TEST_SNPRINTF("1. 1.e+00 1.00000 0.0001 1e-05", "%#.0f %#.0e %#g %g %g", 1.0, 1.0, 1.0, 1e-4, 1e-5);
+    // Precisions longer than the cached digits
+    TEST_SNPRINTF("1.0000000000000000555111512312578270211815834045410156250000000000000000000000000000000000000000000000e-01", "%.100e", 0.1);
+    TEST_SNPRINTF("0.66666666666666662965923251249478198587894439697265625000000000000000000000000000 0.3333333333333333333423683514373792036167287733405828475952148437500000", "%.80f %.70Lf", 2.0 / 3, 1.0L / 3);
+    TEST_SNPRINTF("10 9.9 9.99e+00 9.999999999999999161139200000000000000000000000000000000000000000000e+22", "%.0f %.1f %.2e %.66e", 9.5, 9.95, 9.995, 9.999999999999999e22);
+    // Long double
+    TEST_SNPRINTF("0.1000000000000000000014 1.000000e-4000 1.18973e+4932", "%.22Lf %Le %Lg", 0.1L, 1e-4000L, LDBL_MAX);
+    TEST_SNPRINTF("3.14159265358979323851 -2.5e+00", "%.20Lf %.1Le", 3.14159265358979323846L, -2.5L);
     // Hexadecimal floating point
     TEST_SNPRINTF("0x1.88915b573eab3p+8 0x1.b7cdfd9d7bdbbp-34 0x1.9ap-4 0X1.B7CDFD9D7BDBBP-34", "%a %a %.2a %A", 392.5678, 1e-10, 0.1, 1e-10);
+    TEST_SNPRINTF("0x1p+0 0x0p+0 -0x0p+0 0x0.0000000000001p-1022 0x0.fffffffffffffp-1022", "%a %a %a %a %a", 1.0, 0.0, -0.0, 4.9e-324, 2.2250738585072009e-308);
+    TEST_SNPRINTF("0x2p+0 0x1p+1 0x2p+0 0x1.0p+0 0x1.2p+0 0x1.1p+0 0x1.p+0", "%.0a %.0a %.0a %.1a %.1a %.1a %#.0a", 1.5, 2.5, 1.96875, 1.03125, 1.09375, 1.0390625, 1.0);
+    TEST_SNPRINTF("0x8p-3 0x8p-16385 0x0.000000000000001p-16385 0x0p+0 0x1p+1 0xc.91p-2", "%La %La %La %La %.0La %.2La", 1.0L, LDBL_MIN, LDBL_TRUE_MIN, 0.0L, 1.9375L, 3.14159L);
+    TEST_SNPRINTF("[      0x1p+0] [0x1p+0      ] [-0x000001p+0] [+0x1p+0] [ 0x1p+0] [0X1.FFP+7] [         inf] [0x1.999999999999a0000000p-4]", "[%12a] [%-12a] [%012a] [%+a] [% a] [%A] [%012a] [%.20a]", 1.0, 1.0, -1.0, 1.0, 1.0, 255.5, HUGE_VAL, 0.1);
     TEST_SNPRINTF("Testing flags: 0x1.4p+3  0x1p+0 0x1p+1 0x1.8p+1 +0x1p+2 0x1.0000p+4 0x1.9000p+4", "Testing flags: %4a % 3a %04a %-3a %+2a %5.4a %.4a", 10.0f, 1.0f, 2.0f, 3.0f, 4.0f, 16.0f, 25.0f);
     TEST_SNPRINTF("Testing flags: 0x1.4p+3 +0x1p+0 -0x1p+0 0x1p+1 0x1.b800p+5 +0x0p+0", "Testing flags: %04a %+03a %03a %-03a %-05.4a %+a", 10.0f, 1.0f, -1.0f, 2.0f, 55.0f, 0.0f);
     TEST_SNPRINTF("Testing flags: 0X1.4P+3  0X1P+0 0X1P+1 0X1.8P+1 +0X1P+2 0X1.0000P+4 0X1.9000P+4", "Testing flags: %4A % 3A %04A %-3A %+2A %5.4A %.4A", 10.0f, 1.0f, 2.0f, 3.0f, 4.0f, 16.0f, 25.0f);
@@ -1431,6 +1744,15 @@ static void check_sscanf(void)
     EXPECT_INT(sscanf("1.1,2.2,3.3", " %f,%*f,%f", &float1, &float2), 2);
     EXPECT_FLOAT(float1, 1.1f);
     EXPECT_FLOAT(float2, 3.3f);
+    {
+        double double1;
+        long double ldouble1;
+        EXPECT_INT(sscanf("2.2250738585072011e-308 0.1000000000000000000013552527156068805425093160010874271392822265625", "%lf %Lf", &double1, &ldouble1), 2);
+        EXPECT_DOUBLE(double1, 2.2250738585072011e-308);
+        EXPECT_LDOUBLE(ldouble1, 0.1L);
+        EXPECT_INT(sscanf("9007199254740993xyz", "%18lf", &double1), 1);
+        EXPECT_DOUBLE(double1, 9007199254740992.0);
+    }
     EXPECT_INT(sscanf("1.5e3, 1.7e-62, 8000", " %5f,%4f,%4f", &float1, &float2, &float3), 2);
     EXPECT_FLOAT(float1, 1.5e3f);
     EXPECT_FLOAT(float2, 1.7f);
@@ -1577,10 +1899,586 @@ static void check_sscanf(void)
     EXPECT_INT(sscanf("asd", "%k %r %v %y %"), 0);
 }
 
+#ifdef USE_LIB_CJ
+struct Callback_Output {
+    char str[4096];
+    size_t len;
+    int calls;
+};
+
+static void append_output(void *ctx, const char *str, size_t len)
+{
+    struct Callback_Output *const output = ctx;
+    memcpy(&output->str[output->len], str, len);
+    output->len += len;
+    output->str[output->len] = '\0';
+    output->calls++;
+}
+
+static void check_cj_cbprintf(void)
+{
+    struct Callback_Output output = {0};
+    EXPECT_INT(cj_cbprintf(append_output, &output, "Hello %s %d!", "World", 42), 15);
+    EXPECT_STR(output.str, "Hello World 42!");
+    EXPECT_INT(output.calls, 1);
+    output = (struct Callback_Output){0};
+    EXPECT_INT(cj_cbprintf(append_output, &output, ""), 0);
+    EXPECT_INT(output.calls, 0);
+    // Output larger than the internal chunk is passed in several calls
+    char expected[4096];
+    const char *fmt = "%s|%1500d|%-800.3f|%c";
+    const int len = snprintf(expected, sizeof(expected), fmt, "begin", -7, 2.5, 'z');
+    output = (struct Callback_Output){0};
+    EXPECT_INT(cj_cbprintf(append_output, &output, fmt, "begin", -7, 2.5, 'z'), len);
+    EXPECT_SIZE(output.len, (size_t)len);
+    EXPECT_STR(output.str, expected);
+    EXPECT_TRUE(output.calls >= 3);
+    EXPECT_INT(cj_cbprintf(NULL, NULL, "%d", 1), -1);
+}
+
+static void check_cj_fmt_compile(void)
+{
+    char expected[256];
+    char buffer[256];
+    int count1 = 0, count2 = 0;
+    cj_fmt_compiled compiled = cj_fmt_compile("id=%d name=%-8s|%*.*f %% %y %#llx%n end");
+    EXPECT_INT(compiled.count, 7);
+    for (int i = 0; i < 3; i++) {
+        const int len = snprintf(expected, sizeof(expected), "id=%d name=%-8s|%*.*f %% %y %#llx%n end", i, "abc", 9, i, 3.25, 0xABCULL * (unsigned)i, &count1);
+        EXPECT_INT(cj_fmt_snprintf(&compiled, buffer, sizeof(buffer), i, "abc", 9, i, 3.25, 0xABCULL * (unsigned)i, &count2), len);
+        EXPECT_STR(buffer, expected);
+        EXPECT_INT(count2, count1);
+    }
+    EXPECT_INT(cj_fmt_snprintf(&compiled, buffer, 8, 1, "abc", 9, 1, 3.25, 0ULL, &count2), 39);
+    EXPECT_STR(buffer, "id=1 na");
+    compiled = cj_fmt_compile("No conversions %");
+    EXPECT_INT(compiled.count, 1);
+    EXPECT_INT(cj_fmt_snprintf(&compiled, buffer, sizeof(buffer)), 16);
+    EXPECT_STR(buffer, "No conversions %");
+    // Formats with too many conversions are interpreted
+    const char *many = "%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d";
+    compiled = cj_fmt_compile(many);
+    EXPECT_INT(compiled.count, -1);
+    EXPECT_INT(cj_fmt_snprintf(&compiled, buffer, sizeof(buffer), 1, 2, 3, 4, 5, 6, 7, 8, 9, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 0, 1, 2, 3), 33);
+    EXPECT_STR(buffer, "123456789012345678901234567890123");
+    compiled = cj_fmt_compile(NULL);
+    EXPECT_INT(cj_fmt_snprintf(&compiled, buffer, sizeof(buffer)), -1);
+}
+
+static void check_cj_fmt_cache(void)
+{
+    char buffer[64];
+    char fmt[16] = "<%d>";
+    for (int i = 0; i < 3; i++) {
+        snprintf(buffer, sizeof(buffer), "[%s:%03d]", "cache", i);
+    }
+    EXPECT_STR(buffer, "[cache:002]");
+    // The format changes in the same address
+    snprintf(buffer, sizeof(buffer), fmt, 1);
+    EXPECT_STR(buffer, "<1>");
+    strcpy(fmt, "(%x)");
+    snprintf(buffer, sizeof(buffer), fmt, 255);
+    EXPECT_STR(buffer, "(ff)");
+#ifndef LIBCJ_NO_FMT_CACHE
+    const cj_fmt_cache_stats before = cj_fmt_cache_get_stats();
+    for (int i = 0; i < 10; i++) {
+        snprintf(buffer, sizeof(buffer), "%d-%s", i, "x");
+    }
+    const cj_fmt_cache_stats after = cj_fmt_cache_get_stats();
+    EXPECT_ULLONG(after.misses - before.misses, 1);
+    EXPECT_ULLONG(after.hits - before.hits, 9);
+    // Formats with more conversions than an entry can hold are interpreted every time
+    for (int i = 0; i < 2; i++) {
+        EXPECT_INT(snprintf(buffer, sizeof(buffer), "%d%d%d%d%d%d%d%d", 1, 2, 3, 4, 5, 6, 7, i), 8);
+    }
+    EXPECT_STR(buffer, "12345671");
+    const cj_fmt_cache_stats last = cj_fmt_cache_get_stats();
+    EXPECT_ULLONG(last.misses - after.misses, 2);
+    EXPECT_ULLONG(last.hits - after.hits, 0);
+#endif // LIBCJ_NO_FMT_CACHE
+}
+
+// Formats into chunks of chunk_size characters, that are concatenated in out
+static size_t format_in_chunks(char *out, const size_t chunk_size, const char *fmt, ...)
+{
+    char chunk[17];
+    size_t total = 0;
+    size_t length;
+    cj_fmt_state state;
+    va_list args;
+    va_start(args, fmt);
+    cj_fmt_state_init(&state, fmt, args);
+    memset(chunk, '#', sizeof(chunk));
+    while ((length = cj_fmt_resume(&state, chunk, chunk_size)) > 0) {
+        memcpy(&out[total], chunk, length);
+        total += length;
+        // The chunks aren't null terminated
+        EXPECT_INT(chunk[chunk_size], '#');
+    }
+    cj_fmt_state_end(&state);
+    va_end(args);
+    out[total] = '\0';
+    return total;
+}
+
+static void check_cj_fmt_resume(void)
+{
+    char buffer[128];
+    int position = 0;
+    const char *expected = "name=lib-cj    |   42|3.141593|%|ffff|end";
+    for (size_t chunk_size = 1; chunk_size <= 16; chunk_size++) {
+        EXPECT_SIZE(format_in_chunks(buffer, chunk_size, "name=%-10s|%*d|%f|%%|%x%n|end", "lib-cj", 5, 42, 3.1415926, 0xFFFF, &position), 41);
+        EXPECT_STR(buffer, expected);
+        EXPECT_INT(position, 37);
+    }
+    // Long strings continue from the character where they stopped, also when escaped and padded
+    static char text[6000];
+    static char long_expected[16000];
+    static char long_buffer[16000];
+    for (size_t i = 0; i < sizeof(text) - 1; i++) {
+        text[i] = ((i % 50) == 49) ? '\n' : (char)('a' + i % 26);
+    }
+    const int long_length = snprintf(long_expected, sizeof(long_expected), "<%s|%-7000.5500J|%#*Q>%n", text, text, 9, "q\"", &position);
+    for (size_t chunk_size = 1; chunk_size <= 16; chunk_size += 5) {
+        int long_position = 0;
+        EXPECT_SIZE(format_in_chunks(long_buffer, chunk_size, "<%s|%-7000.5500J|%#*Q>%n", text, text, 9, "q\"", &long_position), (size_t)long_length);
+        EXPECT_STR(long_buffer, long_expected);
+        EXPECT_INT(long_position, position);
+    }
+    EXPECT_SIZE(format_in_chunks(buffer, 3, ""), 0);
+    EXPECT_SIZE(format_in_chunks(buffer, 0, "abc"), 0);
+    EXPECT_SIZE(format_in_chunks(buffer, 4, NULL), 0);
+}
+
+struct Test_Row {
+    const char *name;
+    int id;
+    short level;
+    char grade;
+    double score;
+    int width;
+};
+
+struct Test_Count_Row {
+    int value;
+    int *position;
+};
+
+static void check_cj_format_rows(void)
+{
+    static const struct Test_Row rows[] = {
+        {"alpha", 1, -3, 'a', 0.5, 3},
+        {"beta", -20, 300, 'b', 12.25, 1},
+        {"gamma", 300, 0, 'c', -1.0, 5},
+        {"delta", 4000, 7, 'd', 1e10, 0},
+        {"epsilon", 5, -32768, 'e', 3.14159, 2},
+    };
+    const size_t offsets[] = {
+        offsetof(struct Test_Row, name), offsetof(struct Test_Row, width), offsetof(struct Test_Row, id),
+        offsetof(struct Test_Row, level), offsetof(struct Test_Row, grade), offsetof(struct Test_Row, score),
+    };
+    const char *expected =
+        "alpha,  1,-3,a,0.50\n"
+        "beta,-20,300,b,12.25\n"
+        "gamma,  300,0,c,-1.00\n"
+        "delta,4000,7,d,10000000000.00\n"
+        "epsilon, 5,-32768,e,3.14\n";
+    const cj_fmt_compiled compiled = cj_fmt_compile("%s,%*d,%hd,%c,%.2f\n");
+    const size_t rows_count = sizeof(rows) / sizeof(rows[0]);
+    char buffer[256];
+    EXPECT_INT(cj_format_rows(&compiled, rows, sizeof(rows[0]), rows_count, offsets, buffer, sizeof(buffer)), 118);
+    EXPECT_STR(buffer, expected);
+    for (unsigned threads = 0; threads <= 8; threads++) {
+        memset(buffer, '#', sizeof(buffer));
+        EXPECT_INT(cj_format_rows_parallel(&compiled, rows, sizeof(rows[0]), rows_count, offsets, buffer, sizeof(buffer), threads), 118);
+        EXPECT_STR(buffer, expected);
+        // Truncated in the middle of the output
+        memset(buffer, '#', sizeof(buffer));
+        EXPECT_INT(cj_format_rows_parallel(&compiled, rows, sizeof(rows[0]), rows_count, offsets, buffer, 50, threads), 118);
+        EXPECT_SIZED_STR(buffer, expected, 49);
+        EXPECT_INT(buffer[49], '\0');
+        EXPECT_INT(buffer[50], '#');
+        EXPECT_INT(cj_format_rows_parallel(&compiled, rows, sizeof(rows[0]), rows_count, offsets, NULL, 0, threads), 118);
+    }
+    EXPECT_INT(cj_format_rows(&compiled, rows, sizeof(rows[0]), 0, offsets, buffer, sizeof(buffer)), 0);
+    EXPECT_STR(buffer, "");
+    // %n counts the characters of all the rows before, even without output
+    int serial[7];
+    int parallel[7];
+    struct Test_Count_Row count_rows[7];
+    const size_t count_offsets[] = {offsetof(struct Test_Count_Row, value), offsetof(struct Test_Count_Row, position)};
+    const cj_fmt_compiled count_fmt = cj_fmt_compile("%d:%n;");
+    for (int i = 0; i < 7; i++) {
+        count_rows[i].value = i * 7;
+        count_rows[i].position = &serial[i];
+    }
+    EXPECT_INT(cj_format_rows(&count_fmt, count_rows, sizeof(count_rows[0]), 7, count_offsets, buffer, sizeof(buffer)), 26);
+    EXPECT_STR(buffer, "0:;7:;14:;21:;28:;35:;42:;");
+    EXPECT_INT(serial[6], 25);
+    for (int i = 0; i < 7; i++) {
+        count_rows[i].position = &parallel[i];
+    }
+    for (unsigned threads = 2; threads <= 8; threads += 3) {
+        for (size_t cap = 0; cap <= sizeof(buffer); cap += sizeof(buffer) / 2) {
+            memset(parallel, 0, sizeof(parallel));
+            EXPECT_INT(cj_format_rows_parallel(&count_fmt, count_rows, sizeof(count_rows[0]), 7, count_offsets,
+                (cap > 0) ? buffer : NULL, cap, threads), 26);
+            EXPECT_INT(memcmp(parallel, serial, sizeof(serial)), 0);
+        }
+    }
+}
+
+static void print_ipv4(cj_fmt_output *out, const cj_fmt_spec *spec, const void *arg, void *ctx)
+{
+    const unsigned char *ip = arg;
+    (void)spec;
+    (void)ctx;
+    cj_fmt_writef(out, "%u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+}
+
+static void print_name(cj_fmt_output *out, const cj_fmt_spec *spec, const void *arg, void *ctx)
+{
+    if (spec->alternative) {
+        cj_fmt_write(out, (const char *)ctx, strlen(ctx));
+    }
+    cj_fmt_write_padded(out, spec, arg);
+}
+
+struct Test_Host {
+    const unsigned char *ip;
+    short port;
+};
+
+static void check_cj_fmt_register(void)
+{
+    static struct Test_Host hosts[2000];
+    static char rows_expected[40000];
+    static char rows_buffer[40000];
+    const size_t offsets[] = {offsetof(struct Test_Host, ip), offsetof(struct Test_Host, port)};
+    char buffer[64];
+    const unsigned char ip[4] = {192, 168, 0, 1};
+    const char *fmt = "ip=%V!";
+    EXPECT_INT(snprintf(buffer, sizeof(buffer), fmt, ip), 6);
+    EXPECT_STR(buffer, "ip=%V!");
+    EXPECT_INT(cj_fmt_register('V', print_ipv4, NULL), 0);
+    EXPECT_INT(cj_fmt_register('W', print_name, "name:"), 0);
+    EXPECT_INT(cj_fmt_register('d', print_ipv4, NULL), -1);
+    EXPECT_INT(cj_fmt_register('l', print_ipv4, NULL), -1);
+    EXPECT_INT(cj_fmt_register('%', print_ipv4, NULL), -1);
+    // The format cached before the registration is compiled again
+    EXPECT_INT(snprintf(buffer, sizeof(buffer), fmt, ip), 15);
+    EXPECT_STR(buffer, "ip=192.168.0.1!");
+    EXPECT_INT(snprintf(buffer, sizeof(buffer), "[%8W|%-6.3W|%#W] %d", "abc", "abcdef", "x", 5), 26);
+    EXPECT_STR(buffer, "[     abc|abc   |name:x] 5");
+    EXPECT_INT(snprintf(buffer, 8, "%V%V", ip, ip), 22);
+    EXPECT_STR(buffer, "192.168");
+    EXPECT_INT(cj_fmt_length("%V", ip), 11);
+    const cj_fmt_compiled compiled = cj_fmt_compile("<%V>");
+    EXPECT_INT(cj_fmt_snprintf(&compiled, buffer, sizeof(buffer), ip), 13);
+    EXPECT_STR(buffer, "<192.168.0.1>");
+    // Nested formatting isn't null terminated, the outputs of cj_fmt_resume and of each thread
+    // of cj_format_rows_parallel have no byte reserved for it
+    for (size_t chunk_size = 1; chunk_size <= 4; chunk_size++) {
+        EXPECT_SIZE(format_in_chunks(buffer, chunk_size, "<%V>", ip), 13);
+        EXPECT_STR(buffer, "<192.168.0.1>");
+    }
+    for (size_t i = 0; i < sizeof(hosts) / sizeof(hosts[0]); i++) {
+        hosts[i].ip = ip;
+        hosts[i].port = (short)i;
+    }
+    const cj_fmt_compiled host_fmt = cj_fmt_compile("%V:%hd\n");
+    const int rows_length = cj_format_rows(&host_fmt, hosts, sizeof(hosts[0]), 2000, offsets, rows_expected, sizeof(rows_expected));
+    EXPECT_SIZE(strlen(rows_expected), (size_t)rows_length);
+    for (unsigned threads = 2; threads <= 8; threads++) {
+        EXPECT_INT(cj_format_rows_parallel(&host_fmt, hosts, sizeof(hosts[0]), 2000, offsets, rows_buffer, sizeof(rows_buffer), threads), rows_length);
+        EXPECT_STR(rows_buffer, rows_expected);
+    }
+    EXPECT_INT(cj_fmt_register('V', NULL, NULL), 0);
+    EXPECT_INT(cj_fmt_register('W', NULL, NULL), 0);
+    EXPECT_INT(snprintf(buffer, sizeof(buffer), fmt, ip), 6);
+    EXPECT_STR(buffer, "ip=%V!");
+}
+
+static void check_cj_fmt_length(void)
+{
+    char buffer[16];
+    EXPECT_INT(cj_fmt_length("%d %s %.3f", -123, "abc", 2.5), 14);
+    EXPECT_INT(cj_fmt_length("%-8x|%+05d|%#o", 255U, 7, 8U), 18);
+    EXPECT_INT(cj_fmt_length("%5s|%.2s|%c", (char *)NULL, "abc", 'x'), 11);
+    EXPECT_INT(cj_fmt_length("%.300f", 1e300), 602);
+    EXPECT_INT(cj_fmt_length("%.2e|%.1f|%g", 9.999, 99.95, 0.0001), 21);
+    EXPECT_INT(cj_fmt_length("%La|%10.3a|%f", 1.0L, -0.5, -INFINITY), 23);
+    EXPECT_INT(cj_fmt_length("%p", (void *)NULL), 5);
+    EXPECT_INT(cj_fmt_length("%s", ""), 0);
+    // Truncated output stops generating the characters once the buffer is full
+    EXPECT_INT(snprintf(buffer, 4, "%s%d%.100f", "ab", 12345, 0.1), 109);
+    EXPECT_STR(buffer, "ab1");
+}
+
+static void check_cj_constant_fmt(void)
+{
+    char buffer[64];
+    const char *null_str = NULL;
+    const char *fmt = "%d";
+    const cj_fmt_cache_stats before = cj_fmt_cache_get_stats();
+    EXPECT_INT(snprintf(buffer, sizeof(buffer), "%d", INT_MIN), 11);
+    EXPECT_STR(buffer, "-2147483648");
+    EXPECT_INT(snprintf(buffer, 3, "%u", 12345U), 5);
+    EXPECT_STR(buffer, "12");
+    EXPECT_INT(snprintf(buffer, sizeof(buffer), "%ld %lu", LONG_MIN, ULONG_MAX), 41);
+    EXPECT_INT(snprintf(buffer, sizeof(buffer), "%lld", LLONG_MAX), 19);
+    EXPECT_STR(buffer, "9223372036854775807");
+    EXPECT_INT(snprintf(buffer, sizeof(buffer), "%llu", ULLONG_MAX), 20);
+    EXPECT_STR(buffer, "18446744073709551615");
+    EXPECT_INT(snprintf(buffer, sizeof(buffer), "%s", null_str), 6);
+    EXPECT_STR(buffer, "(null)");
+    EXPECT_INT(snprintf(buffer, sizeof(buffer), "%s=%s", "key", "value"), 9);
+    EXPECT_STR(buffer, "key=value");
+    EXPECT_INT(snprintf(buffer, 6, "%s=%d", "key", -17), 7);
+    EXPECT_STR(buffer, "key=-");
+    EXPECT_INT(snprintf(NULL, 0, "%d", 100), 3);
+#ifndef LIBCJ_NO_FMT_CACHE
+    // Only the call with two conversions above went through __vsnprintf
+    const cj_fmt_cache_stats after = cj_fmt_cache_get_stats();
+    EXPECT_ULLONG((after.hits + after.misses) - (before.hits + before.misses), 1);
+#endif // LIBCJ_NO_FMT_CACHE
+    (void)before;
+    // Formats that aren't constant or arguments of other types use the generic path
+    EXPECT_INT(snprintf(buffer, sizeof(buffer), fmt, 5), 1);
+    EXPECT_STR(buffer, "5");
+    EXPECT_INT(snprintf(buffer, sizeof(buffer), "%d", (short)-3), 2);
+    EXPECT_STR(buffer, "-3");
+    EXPECT_INT(snprintf(buffer, sizeof(buffer), "%s=%d", "x", 'c'), 4);
+    EXPECT_STR(buffer, "x=99");
+}
+
+static void check_cj_log(void)
+{
+    const cj_fmt_compiled formats[] = {
+        cj_fmt_compile("%s=%d\n"),
+        cj_fmt_compile("[%*.*s|%hhd|%hu|%ld|%lld|%c]\n"),
+        cj_fmt_compile("%.3f %Lg %e %#J%n\n"),
+    };
+    unsigned char buffer[128];
+    char expected[512];
+    char name[8] = "alpha";
+    int count = -1;
+    struct Callback_Output output = {{0}, 0, 0};
+    cj_log_ring ring;
+    cj_log_init(&ring, buffer, sizeof(buffer), formats, 3);
+    EXPECT_INT(cj_log_capture(&ring, 0, name, 42), 0);
+    strcpy(name, "beta"); // Strings are copied when captured
+    EXPECT_INT(cj_log_capture(&ring, 1, 6, 3, "abcdef", (char)-5, (unsigned short)65535, -7L, 1LL << 40, 'x'), 0);
+    EXPECT_INT(cj_log_capture(&ring, 2, 3.14159, 2.5L, 1e10, "a\"b", &count), 0);
+    EXPECT_INT(cj_log_capture(&ring, 3, 1), -1);
+    EXPECT_SIZE(ring.dropped, 1);
+    EXPECT_INT(cj_log_decode(&ring, append_output, &output), 76);
+    EXPECT_STR(output.str, "alpha=42\n[   abc|-5|65535|-7|1099511627776|x]\n3.142 2.5 1.000000e+10 \"a\\\"b\"\n");
+    EXPECT_INT(count, -1);
+    EXPECT_SIZE(ring.used, 0);
+    // Records wrap around the end of the ring, and the ones that don't fit are dropped
+    output.len = 0;
+    int expected_len = 0;
+    for (int i = 0; i < 20; i++) {
+        if (cj_log_capture(&ring, 0, "key", i) != 0) {
+            EXPECT_TRUE(cj_log_decode(&ring, append_output, &output) > 0);
+            EXPECT_INT(cj_log_capture(&ring, 0, "key", i), 0);
+        }
+        expected_len += sprintf(&expected[expected_len], "key=%d\n", i);
+    }
+    EXPECT_TRUE(cj_log_decode(&ring, append_output, &output) > 0);
+    EXPECT_STR(output.str, expected);
+    EXPECT_SIZE(ring.dropped, 3);
+    // Records larger than the ring
+    memset(expected, 'k', 200);
+    expected[200] = '\0';
+    EXPECT_INT(cj_log_capture(&ring, 0, expected, 1), -1);
+    EXPECT_INT(cj_log_decode(&ring, append_output, &output), 0);
+    // Strings are truncated to the size of the payload, leaving room for the other arguments
+    static unsigned char large_buffer[4096];
+    static char key[2048];
+    memset(key, 'k', sizeof(key) - 1);
+    cj_log_init(&ring, large_buffer, sizeof(large_buffer), formats, 3);
+    EXPECT_INT(cj_log_capture(&ring, 0, key, 7), 0);
+    EXPECT_INT(cj_log_capture(&ring, 1, 4, 2000, key, (char)1, (unsigned short)2, 3L, 4LL, 'y'), 0);
+    output.len = 0;
+    EXPECT_INT(cj_log_decode(&ring, append_output, &output), 1022 + 1008);
+    EXPECT_SIZED_STR(&output.str[1019], "=7\n[kkkk", 8);
+    EXPECT_STR(&output.str[1022 + 994], "kk|1|2|3|4|y]\n");
+}
+
+static void check_cj_print(void)
+{
+    char buffer[128];
+    const char *name = "lib-cj";
+    const unsigned char byte = 200;
+    const short negative = -2;
+    const char c = 'z';
+    EXPECT_INT(cj_print(buffer, sizeof(buffer), "id=", 42, " name=", name, " ratio=", 0.25), 28);
+    EXPECT_STR(buffer, "id=42 name=lib-cj ratio=0.25");
+    EXPECT_INT(cj_print(buffer, sizeof(buffer), LLONG_MIN, " ", ULLONG_MAX, " ", byte, " ", c), 47);
+    EXPECT_STR(buffer, "-9223372036854775808 18446744073709551615 200 z");
+    // Modifiers
+    EXPECT_INT(cj_print(buffer, sizeof(buffer), "[", cj_width(name, 8), "|", cj_width(name, -8), "]"), 19);
+    EXPECT_STR(buffer, "[  lib-cj|lib-cj  ]");
+    EXPECT_INT(cj_print(buffer, sizeof(buffer), cj_hex(255U), " ", cj_hex(negative), " ", cj_prec(cj_hex(10), 4)), 12);
+    EXPECT_STR(buffer, "ff fffe 000a");
+    EXPECT_INT(cj_print(buffer, sizeof(buffer), cj_prec(3.14159, 2), " ", cj_width(cj_prec(name, 3), 5), " ", cj_width(c, 3)), 14);
+    EXPECT_STR(buffer, "3.14   lib   z");
+    EXPECT_INT(cj_print(buffer, sizeof(buffer), cj_hex(1.0), " ", 1e100L, " ", (void *)NULL, " ", (const char *)NULL), 26);
+    EXPECT_STR(buffer, "0x1p+0 1e+100 (nil) (null)");
+    // Truncation and sizing
+    EXPECT_INT(cj_print(buffer, 6, "value=", 1234), 10);
+    EXPECT_STR(buffer, "value");
+    EXPECT_INT(cj_print(NULL, 0, -1, "x"), 3);
+}
+
+static void *test_allocator(void *ctx, void *ptr, size_t size)
+{
+    int *const calls = ctx;
+    (*calls)++;
+    if (size == 0) {
+        free(ptr);
+        return NULL;
+    }
+    return realloc(ptr, size);
+}
+
+static void *failing_allocator(void *ctx, void *ptr, size_t size)
+{
+    (void)ctx;
+    (void)ptr;
+    (void)size;
+    return NULL;
+}
+
+static void check_cj_sb(void)
+{
+    char expected[2048];
+    int calls = 0;
+    cj_sb sb;
+    cj_sb_init(&sb, test_allocator, &calls);
+    EXPECT_INT(cj_sb_appendf(&sb, "%s %d", "Hello", 1), 7);
+    EXPECT_STR(sb.str, "Hello 1");
+    EXPECT_SIZE(sb.length, 7);
+    EXPECT_INT(cj_sb_putc(&sb, '!'), 1);
+    EXPECT_INT(cj_sb_append(&sb, " World", 6), 6);
+    EXPECT_STR(sb.str, "Hello 1! World");
+    EXPECT_INT(calls, 1);
+    // The formatting continues where the capacity ran out
+    const int len = snprintf(expected, sizeof(expected), "Hello 1! World|%1000.3f|%-500s|%x", 3.14159, "left", 255);
+    EXPECT_INT(cj_sb_appendf(&sb, "|%1000.3f|%-500s|%x", 3.14159, "left", 255), len - 14);
+    EXPECT_SIZE(sb.length, (size_t)len);
+    EXPECT_STR(sb.str, expected);
+    EXPECT_TRUE(sb.capacity > sb.length);
+    EXPECT_INT(calls, 6);
+    cj_sb_free(&sb);
+    EXPECT_INT(calls, 7);
+    EXPECT_PTR(sb.str, NULL);
+    EXPECT_SIZE(sb.length, 0);
+    // Allocation failures are reported, and the builder keeps what fit
+    cj_sb_init(&sb, failing_allocator, NULL);
+    EXPECT_INT(cj_sb_appendf(&sb, "%d", 10), -1);
+    EXPECT_PTR(sb.str, NULL);
+    EXPECT_INT(cj_sb_putc(&sb, 'a'), -1);
+    EXPECT_INT(sb.error, 1);
+}
+
+static void check_tprintf(void)
+{
+    char expected[1024];
+    int calls = 0;
+    // Several outputs are valid at the same time
+    const char *first = tprintf("%d-%s", 1, "one");
+    const char *second = tprintf("%d-%s", 2, "two");
+    EXPECT_STR(first, "1-one");
+    EXPECT_STR(second, "2-two");
+    for (int i = 0; i < 6; i++) {
+        tprintf("%d", i);
+    }
+    EXPECT_STR(first, "1-one");
+    EXPECT_STR(tprintf("%d", 3), "3");
+    EXPECT_STR(first, "3");
+    // Without allocator, long outputs take all the slots and are truncated
+    snprintf(expected, sizeof(expected), "%800d", 42);
+    EXPECT_STR(tprintf("%800d", 42), expected);
+    EXPECT_SIZE(strlen(tprintf("%5000d", 42)), 4095);
+    cj_tprintf_allocator(failing_allocator, NULL);
+    EXPECT_STR(tprintf("%800d", 42), expected);
+    // The output of invalid calls is empty
+    char *volatile null_fmt = NULL;
+    EXPECT_STR(tprintf(null_fmt), "");
+    // Long outputs spill to the arena, without using a slot
+    cj_tprintf_allocator(test_allocator, &calls);
+    second = tprintf("%d-%s", 2, "two");
+    const char *long_output = tprintf("%800d", 42);
+    EXPECT_STR(long_output, expected);
+    EXPECT_STR(tprintf("%20000d", 7) + 19999, "7");
+    EXPECT_STR(long_output, expected);
+    EXPECT_STR(second, "2-two");
+    EXPECT_INT(calls, 2);
+    cj_tprintf_reset();
+    EXPECT_INT(calls, 3);
+    EXPECT_STR(tprintf("%800d", 42), expected);
+    EXPECT_INT(calls, 3);
+    cj_tprintf_free();
+    EXPECT_INT(calls, 4);
+    cj_tprintf_allocator(NULL, NULL);
+}
+
+#ifdef LIBCJ_POSIX
+static void check_cj_dprintf(void)
+{
+    const char payload[] = "a string larger than the buffer of the file";
+    char expected[256];
+    char received[256];
+    char buffer[16];
+    int fds[2];
+    cj_file file;
+    EXPECT_INT(pipe(fds), 0);
+    cj_file_init(&file, fds[1], buffer, sizeof(buffer));
+    EXPECT_INT(cj_dprintf(&file, "%d-%s;", 12, "ab"), 6);
+    EXPECT_SIZE(file.length, 6); // Still in the buffer
+    EXPECT_INT(cj_dprintf(&file, "[%s] %5.1f", payload, 2.25), 51);
+    EXPECT_INT(cj_dprintf(&file, "%-40d|", 7), 41);
+    EXPECT_INT(cj_file_flush(&file), 0);
+    EXPECT_SIZE(file.length, 0);
+    const int len = snprintf(expected, sizeof(expected), "12-ab;[%s]   2.2%-40d|", payload, 7);
+    EXPECT_INT((int)read(fds[0], received, sizeof(received)), len);
+    EXPECT_SIZED_STR(received, expected, (size_t)len);
+    close(fds[0]);
+    close(fds[1]);
+    // Errors are reported by the writes that fail and by the next flushes
+    cj_file_init(&file, -1, buffer, sizeof(buffer));
+    EXPECT_INT(cj_dprintf(&file, "%d", 1), 1);
+    EXPECT_INT(cj_file_flush(&file), -1);
+    EXPECT_INT(cj_dprintf(&file, "%s", payload), -1);
+    EXPECT_INT(cj_dprintf(NULL, "%d", 1), -1);
+}
+#endif // LIBCJ_POSIX
+#endif // USE_LIB_CJ
+
 static void check_stdio(void)
 {
     check_snprintf();
     check_sscanf();
+#ifdef USE_LIB_CJ
+    check_cj_cbprintf();
+    check_cj_fmt_compile();
+    check_cj_fmt_cache();
+    check_cj_fmt_length();
+    check_cj_fmt_resume();
+    check_cj_format_rows();
+    check_cj_fmt_register();
+    check_cj_log();
+    check_cj_print();
+    check_cj_constant_fmt();
+    check_cj_sb();
+    check_tprintf();
+#ifdef LIBCJ_POSIX
+    check_cj_dprintf();
+#endif // LIBCJ_POSIX
+#endif // USE_LIB_CJ
 }
 
 //------------------------------------------------------------------------------